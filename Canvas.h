@@ -0,0 +1,153 @@
+#pragma once
+#include <windows.h>
+#include <emmintrin.h>
+#include <algorithm>
+#include <cstdint>
+
+// ------------------------------
+// Software canvas: a DIB section drawn on the CPU, blitted by dirty rect
+// ------------------------------
+//
+// The window owns one top-down 32-bit DIB section selected into a memory
+// DC. Fills write the pixels directly, four at a time with SSE2. GDI (text)
+// draws into the same DC. Call GdiFlush before touching pixels after any
+// GDI call. Only the rectangles that changed are copied to the screen.
+
+static constexpr int kMaxDirtyRects = 8;
+
+struct Canvas {
+    HDC       dc = nullptr;   // memory DC, the DIB is selected into it
+    HBITMAP   bmp = nullptr;
+    HGDIOBJ   old = nullptr;
+    uint32_t* px = nullptr;   // 0x00RRGGBB, rows top to bottom
+    int       w = 0, h = 0;
+};
+
+static inline void canvas_release(Canvas& c) {
+    if (c.dc) {
+        SelectObject(c.dc, c.old);
+        DeleteDC(c.dc);
+    }
+    if (c.bmp) DeleteObject(c.bmp);
+    c.dc = nullptr;
+    c.bmp = nullptr;
+    c.old = nullptr;
+    c.px = nullptr;
+    c.w = c.h = 0;
+}
+
+// (Re)create at the client size; `ref` is a DC on the target window
+static inline bool canvas_resize(Canvas& c, HDC ref, int w, int h) {
+    canvas_release(c);
+    if (w <= 0 || h <= 0) return false;
+    BITMAPINFO bi{};
+    bi.bmiHeader.biSize = sizeof(bi.bmiHeader);
+    bi.bmiHeader.biWidth = w;
+    bi.bmiHeader.biHeight = -h; // top-down
+    bi.bmiHeader.biPlanes = 1;
+    bi.bmiHeader.biBitCount = 32;
+    bi.bmiHeader.biCompression = BI_RGB;
+    void* bits = nullptr;
+    c.dc = CreateCompatibleDC(ref);
+    c.bmp = c.dc ? CreateDIBSection(c.dc, &bi, DIB_RGB_COLORS, &bits, nullptr, 0) : nullptr;
+    if (!c.bmp || !bits) { canvas_release(c); return false; }
+    c.old = SelectObject(c.dc, c.bmp);
+    c.px = static_cast<uint32_t*>(bits);
+    c.w = w;
+    c.h = h;
+    return true;
+}
+
+static inline RECT canvas_clip(const Canvas& c, const RECT& r) {
+    RECT o;
+    o.left = std::max<LONG>(r.left, 0);
+    o.top = std::max<LONG>(r.top, 0);
+    o.right = std::min<LONG>(r.right, c.w);
+    o.bottom = std::min<LONG>(r.bottom, c.h);
+    return o;
+}
+
+static inline bool rect_empty(const RECT& r) { return r.right <= r.left || r.bottom <= r.top; }
+
+static inline bool rect_equal(const RECT& a, const RECT& b) {
+    return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+}
+
+static inline RECT rect_intersect(const RECT& a, const RECT& b) {
+    RECT o;
+    o.left = std::max(a.left, b.left);
+    o.top = std::max(a.top, b.top);
+    o.right = std::min(a.right, b.right);
+    o.bottom = std::min(a.bottom, b.bottom);
+    return o;
+}
+
+static inline RECT rect_union(const RECT& a, const RECT& b) {
+    RECT o;
+    o.left = std::min(a.left, b.left);
+    o.top = std::min(a.top, b.top);
+    o.right = std::max(a.right, b.right);
+    o.bottom = std::max(a.bottom, b.bottom);
+    return o;
+}
+
+// Solid fill, clipped to the canvas
+static inline void canvas_fill(Canvas& c, const RECT& r, uint32_t color) {
+    const RECT k = canvas_clip(c, r);
+    if (rect_empty(k)) return;
+    const __m128i v = _mm_set1_epi32(int(color));
+    for (LONG y = k.top; y < k.bottom; ++y) {
+        uint32_t* p = c.px + size_t(y) * c.w + k.left;
+        uint32_t* end = c.px + size_t(y) * c.w + k.right;
+        while (p < end && (reinterpret_cast<uintptr_t>(p) & 15)) *p++ = color;
+        for (; p + 4 <= end; p += 4) _mm_store_si128(reinterpret_cast<__m128i*>(p), v);
+        while (p < end) *p++ = color;
+    }
+}
+
+static inline void canvas_blit(const Canvas& c, HDC dst, const RECT& r) {
+    const RECT k = canvas_clip(c, r);
+    if (rect_empty(k)) return;
+    BitBlt(dst, k.left, k.top, k.right - k.left, k.bottom - k.top, c.dc, k.left, k.top, SRCCOPY);
+}
+
+// Rectangles changed this frame. Overlapping ones are merged; when the list
+// is full the newcomer is merged into the last entry.
+struct DirtyRects {
+    RECT r[kMaxDirtyRects];
+    int  n = 0;
+};
+
+static inline void dirty_add(DirtyRects& d, const RECT& r) {
+    if (rect_empty(r)) return;
+    for (int i = 0; i < d.n; ++i) {
+        if (!rect_empty(rect_intersect(d.r[i], r))) { d.r[i] = rect_union(d.r[i], r); return; }
+    }
+    if (d.n < kMaxDirtyRects) d.r[d.n++] = r;
+    else d.r[d.n - 1] = rect_union(d.r[d.n - 1], r);
+}
+
+// ------------------------------
+// Frame timing
+// ------------------------------
+
+struct FrameStats {
+    double   last = 0.0;          // start of the previous frame
+    float    intervalMs = 0.0f;   // smoothed frame-to-frame interval
+    float    worstMs = 0.0f;      // longest interval since the last readout
+    float    drawUs = 0.0f;       // smoothed CPU time per frame (draw + blit)
+    uint32_t frames = 0;
+    uint32_t late = 0;            // intervals over 1.5 refresh periods
+};
+
+static inline void frame_stats_update(FrameStats& s, double start, double end, double refreshPeriod) {
+    if (s.last > 0.0) {
+        const float ms = float((start - s.last) * 1000.0);
+        s.intervalMs += 0.05f * (ms - s.intervalMs);
+        s.worstMs = std::max(s.worstMs, ms);
+        if (ms > 1500.0 * refreshPeriod) ++s.late;
+    }
+    s.drawUs += 0.05f * (float((end - start) * 1e6) - s.drawUs);
+    s.last = start;
+    ++s.frames;
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "Engine.h"
+
+// ------------------------------
+// Config file (theremin.cfg), reloaded while playing
+// ------------------------------
+//
+// One `key = value` per line; blank lines and '#' comments are skipped.
+// Keys left out keep their defaults.
+//
+//   pitch_min_hz = 100       pitch axis range
+//   pitch_max_hz = 2000
+//   pitch_curve  = 1         exponent on x: > 1 gives the low notes more room
+//   gain_curve   = 1         exponent on the volume axis
+//   pitch_slew   = 0.05      fixed per-sample slews (adaptive glide off)
+//   gain_slew    = 0.075
+//   latency_ms   = 20        device buffer; a change reopens the device
+//   eq.3 = peak 450 -4 2     EQ band 1-6: type Hz gain-dB Q, or "off"; types
+//                            highpass lowshelf peak highshelf lowpass
+//   key.E        = eq        bind a key (A-Z, 0-9, Space, Enter, Backspace,
+//   key.F1       = none      Delete, Escape, Plus, Minus, F1-F12) to an action
+
+enum class KeyAction : uint8_t {
+    None, Mode1, Mode2, Mode3, Mode4, Eq, Comp, Harmony, HarmonyHq, Vocoder, Delay, Adaptive,
+    MasterUp, MasterDown, AutoGain, ResetLoudness, Record, RecordMode, Chord, Predict, RawInput,
+    Latch, Release, ReleaseAll, Mute, Quit,
+    Count
+};
+
+static const char* const kKeyActionNames[] = {
+    "none", "mode1", "mode2", "mode3", "mode4", "eq", "comp", "harmony", "harmony_hq", "vocoder", "delay", "adaptive",
+    "master_up", "master_down", "auto_gain", "reset_loudness", "record", "record_mode", "chord", "predict", "raw_input",
+    "latch", "release", "release_all", "mute", "quit",
+};
+static_assert(sizeof(kKeyActionNames) / sizeof(kKeyActionNames[0]) == size_t(KeyAction::Count), "one name per action");
+
+static const char* const kEqTypeNames[] = { "highpass", "lowshelf", "peak", "highshelf", "lowpass" };
+
+struct AppConfig {
+    EngineConfig engine;
+    EqBand       eq[kEqBands];
+    float        latencyMs = 20.0f;       // device-level
+    KeyAction    keys[256] = {};          // by virtual-key code
+};
+
+// Virtual-key codes for the named keys (the same values as VK_*)
+struct ConfigKeyName { const char* name; uint8_t vk; };
+static const ConfigKeyName kConfigKeyNames[] = {
+    { "Space", 0x20 }, { "Enter", 0x0D }, { "Backspace", 0x08 }, { "Delete", 0x2E }, { "Escape", 0x1B },
+    { "Plus", 0xBB }, { "Minus", 0xBD }, { "NumPlus", 0x6B }, { "NumMinus", 0x6D },
+};
+
+// The stock bindings
+static inline void config_defaults(AppConfig& c) {
+    c = AppConfig();
+    for (int b = 0; b < kEqBands; ++b) c.eq[b] = kEqDefaultBands[b];
+    KeyAction* k = c.keys;
+    k['1'] = KeyAction::Mode1; k['2'] = KeyAction::Mode2; k['3'] = KeyAction::Mode3; k['4'] = KeyAction::Mode4;
+    k['E'] = KeyAction::Eq; k['C'] = KeyAction::Comp; k['H'] = KeyAction::Harmony; k['Q'] = KeyAction::HarmonyHq;
+    k['V'] = KeyAction::Vocoder; k['D'] = KeyAction::Delay; k['A'] = KeyAction::Adaptive;
+    k[0xBB] = KeyAction::MasterUp; k[0x6B] = KeyAction::MasterUp;
+    k[0xBD] = KeyAction::MasterDown; k[0x6D] = KeyAction::MasterDown;
+    k['G'] = KeyAction::AutoGain; k['L'] = KeyAction::ResetLoudness; k['R'] = KeyAction::Record;
+    k['T'] = KeyAction::RecordMode; k['K'] = KeyAction::Chord; k['P'] = KeyAction::Predict; k['I'] = KeyAction::RawInput;
+    k[0x0D] = KeyAction::Latch; k[0x08] = KeyAction::Release; k[0x2E] = KeyAction::ReleaseAll;
+    k[0x20] = KeyAction::Mute; k[0x1B] = KeyAction::Quit;
+}
+
+// "E", "7", "F5", "Space"... -> virtual-key code, 0 if unknown
+static inline int config_key_code(const std::string& name) {
+    if (name.size() == 1 && (isupper(uint8_t(name[0])) || isdigit(uint8_t(name[0])))) return name[0];
+    if (name.size() >= 2 && name[0] == 'F') {
+        const int n = atoi(name.c_str() + 1);
+        if (n >= 1 && n <= 12 && name == "F" + std::to_string(n)) return 0x70 + n - 1;
+    }
+    for (const ConfigKeyName& k : kConfigKeyNames)
+        if (name == k.name) return k.vk;
+    return 0;
+}
+
+static inline std::string config_trim(const std::string& s) {
+    size_t a = 0, b = s.size();
+    while (a < b && isspace(uint8_t(s[a]))) ++a;
+    while (b > a && isspace(uint8_t(s[b - 1]))) --b;
+    return s.substr(a, b - a);
+}
+
+static inline bool config_number(const std::string& s, float lo, float hi, float& v) {
+    char* end = nullptr;
+    const double d = strtod(s.c_str(), &end);
+    if (s.empty() || *end != '\0' || !(d >= lo && d <= hi)) return false;
+    v = float(d);
+    return true;
+}
+
+// "peak 450 -4 2" or "off" -> band; false if malformed or out of range
+static inline bool config_eq_band(const std::string& value, EqBand& b) {
+    if (value == "off") { b.enabled = false; return true; }
+    char type[16] = {};
+    float hz = 0.0f, gain = 0.0f, q = 0.0f;
+    char extra = 0;
+    if (sscanf(value.c_str(), "%15s %f %f %f %c", type, &hz, &gain, &q, &extra) != 4) return false;
+    if (!(hz >= kEqMinHz && hz <= kEqMaxHz) || !(fabsf(gain) <= kEqMaxGainDb) || !(q >= kEqMinQ && q <= kEqMaxQ))
+        return false;
+    for (int t = 0; t < int(sizeof(kEqTypeNames) / sizeof(kEqTypeNames[0])); ++t) {
+        if (strcmp(type, kEqTypeNames[t]) != 0) continue;
+        b.type = EqBandType(t);
+        b.hz = hz; b.gainDb = gain; b.q = q;
+        b.enabled = true;
+        return true;
+    }
+    return false;
+}
+
+// Parse over the defaults. Returns false (and the 1-based line) on the first
+// line it cannot read, or with line 0 when the pitch range is too narrow;
+// `out` is then incomplete and should be dropped.
+static inline bool config_parse(const char* text, size_t size, AppConfig& out, int* errorLine) {
+    config_defaults(out);
+    const std::string src(text, size);
+    size_t pos = 0;
+    for (int line = 1; pos < src.size(); ++line) {
+        size_t end = src.find('\n', pos);
+        if (end == std::string::npos) end = src.size();
+        std::string l = src.substr(pos, end - pos);
+        pos = end + 1;
+        const size_t hash = l.find('#');
+        if (hash != std::string::npos) l.resize(hash);
+
+        // key = value, both trimmed
+        const size_t eq = l.find('=');
+        if (eq == std::string::npos) {
+            if (!config_trim(l).empty()) { if (errorLine) *errorLine = line; return false; }
+            continue;
+        }
+        const std::string key = config_trim(l.substr(0, eq)), value = config_trim(l.substr(eq + 1));
+
+        EngineConfig& e = out.engine;
+        bool ok = true;
+        if (key == "pitch_min_hz")      ok = config_number(value, 20.0f, 4000.0f, e.minHz);
+        else if (key == "pitch_max_hz") ok = config_number(value, 40.0f, 12000.0f, e.maxHz);
+        else if (key == "pitch_curve")  ok = config_number(value, 0.25f, 4.0f, e.pitchCurve);
+        else if (key == "gain_curve")   ok = config_number(value, 0.25f, 4.0f, e.gainCurve);
+        else if (key == "pitch_slew")   ok = config_number(value, 0.001f, 1.0f, e.hzSmooth);
+        else if (key == "gain_slew")    ok = config_number(value, 0.001f, 1.0f, e.gainSmooth);
+        else if (key == "latency_ms")   ok = config_number(value, 3.0f, 500.0f, out.latencyMs);
+        else if (key.size() == 4 && key.compare(0, 3, "eq.") == 0 && key[3] >= '1' && key[3] < '1' + kEqBands)
+            ok = config_eq_band(value, out.eq[key[3] - '1']);
+        else if (key.compare(0, 4, "key.") == 0) {
+            const int vk = config_key_code(key.substr(4));
+            ok = false;
+            for (int a = 0; vk && a < int(KeyAction::Count); ++a)
+                if (value == kKeyActionNames[a]) { out.keys[vk] = KeyAction(a); ok = true; }
+        } else {
+            ok = false;
+        }
+        if (!ok) { if (errorLine) *errorLine = line; return false; }
+    }
+    if (out.engine.maxHz < out.engine.minHz * 1.5f) { if (errorLine) *errorLine = 0; return false; }
+    return true;
+}
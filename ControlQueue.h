@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// ------------------------------
+// Control event queue (many producers, one consumer)
+// ------------------------------
+//
+// Input sources (window messages, raw input, polling threads) push
+// timestamped events; the audio thread drains them once per device buffer.
+// Bounded and lock-free: every cell carries a sequence number that says
+// whether it is free for the producer claiming that position or full for
+// the consumer. A push that finds the queue full drops the event and counts
+// it, so no producer ever waits on the audio thread.
+//
+// Under a flood the last kControlReserve cells are kept for the discrete
+// events (latch, release): a continuous one only restates a position or
+// level that the next of its kind supersedes, so it is dropped first.
+
+static constexpr uint32_t kControlQueueSize = 1024; // power of two
+static constexpr uint32_t kControlReserve = 64;     // cells only discrete events may take
+
+enum class ControlType : uint16_t {
+    Position,   // absolute, x/y normalised 0..1 over the play area
+    Motion,     // relative, x/y in play-area widths/heights
+    Gain,       // absolute volume 0..1 in x (pressure, trigger)
+    Vibrato,    // depth 0..1 in x, held per source
+    Latch,      // freeze the live voice into a drone
+    Release,    // fade the newest drone, or all of them when x > 0.5
+};
+
+// Latch and Release act once; losing one would be heard
+static inline bool control_discrete(ControlType t) {
+    return t == ControlType::Latch || t == ControlType::Release;
+}
+
+enum class ControlSource : uint16_t { Mouse, RawMouse, Pen, Gamepad, Keyboard, Script, Host };
+static constexpr int kControlSources = 7;
+
+struct ControlEvent {
+    double        t = 0.0;       // NowSeconds() when the input arrived
+    float         x = 0.0f, y = 0.0f;
+    ControlType   type = ControlType::Position;
+    ControlSource source = ControlSource::Mouse;
+};
+
+struct ControlQueue {
+    struct Cell {
+        std::atomic<uint32_t> seq;
+        ControlEvent          ev;
+    };
+    Cell cells[kControlQueueSize];
+    alignas(64) std::atomic<uint32_t> enqueuePos{ 0 };
+    alignas(64) uint32_t              dequeuePos = 0;  // consumer only
+    std::atomic<uint32_t> pushed{ 0 };
+    std::atomic<uint32_t> dropped{ 0 };
+    std::atomic<uint32_t> coalesced{ 0 }; // consumer: moves merged into a later one
+    std::atomic<uint32_t> peak{ 0 };      // consumer: most events waiting at a drain
+
+    ControlQueue() {
+        for (uint32_t i = 0; i < kControlQueueSize; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+};
+
+// Any thread
+static inline bool control_push(ControlQueue& q, const ControlEvent& e) {
+    const bool discrete = control_discrete(e.type);
+    uint32_t pos = q.enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        ControlQueue::Cell& c = q.cells[pos & (kControlQueueSize - 1)];
+        const int32_t diff = int32_t(c.seq.load(std::memory_order_acquire) - pos);
+        if (diff == 0) {
+            // Within kControlReserve of full: the cell that far ahead is not free yet
+            const uint32_t ahead = pos + kControlReserve;
+            if (!discrete &&
+                int32_t(q.cells[ahead & (kControlQueueSize - 1)].seq.load(std::memory_order_acquire) - ahead) < 0) {
+                q.dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            if (q.enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                c.ev = e;
+                c.seq.store(pos + 1, std::memory_order_release);
+                q.pushed.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        } else if (diff < 0) {
+            q.dropped.fetch_add(1, std::memory_order_relaxed); // full
+            return false;
+        } else {
+            pos = q.enqueuePos.load(std::memory_order_relaxed); // another producer won
+        }
+    }
+}
+
+// Consumer thread only
+static inline bool control_pop(ControlQueue& q, ControlEvent& e) {
+    ControlQueue::Cell& c = q.cells[q.dequeuePos & (kControlQueueSize - 1)];
+    if (int32_t(c.seq.load(std::memory_order_acquire) - (q.dequeuePos + 1)) < 0) return false;
+    e = c.ev;
+    c.seq.store(q.dequeuePos + kControlQueueSize, std::memory_order_release);
+    ++q.dequeuePos;
+    return true;
+}
+
+// Consumer thread only: events waiting
+static inline uint32_t control_pending(const ControlQueue& q) {
+    return q.enqueuePos.load(std::memory_order_relaxed) - q.dequeuePos;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// ------------------------------
+// Control-rate (k-rate) tier
+// ------------------------------
+//
+// Slow modulation is evaluated once every `controlFrames` samples and ramped
+// linearly to audio rate, so its cost is divided by the control period.
+// Anything that must be sample-accurate (oscillator phase, pitch marks,
+// noise) stays at audio rate.
+
+static constexpr uint32_t kControlFrames = 16;     // default control period
+static constexpr uint32_t kMaxControlFrames = 64;
+
+enum class ModRate { Audio, Control, Block };
+
+// Every modulation source/destination in the voice and the rate it runs at
+struct ModRoute {
+    const char* source;
+    const char* destination;
+    ModRate     rate;
+};
+
+static const ModRoute kModRoutes[] = {
+    { "mouse X (targetHz)",  "pitch slew",        ModRate::Control },
+    { "pitch slew",          "oscillator pitch",  ModRate::Control }, // ramped per sample
+    { "vibrato LFO 5.5 Hz",  "oscillator pitch",  ModRate::Control },
+    { "mouse X (chord root)", "pool voice pitch", ModRate::Block }, // quantised per block
+    { "mouse Y (targetGain)", "voice gain",       ModRate::Block },
+    { "mute / master / trim", "voice gain",       ModRate::Block },
+    { "oscillator A",        "ring mod, shaper",  ModRate::Audio },
+    { "oscillator B",        "ring mod",          ModRate::Audio },
+    { "noise",               "airy mode",         ModRate::Audio },
+    { "oscillator A wrap",   "harmonizer marks",  ModRate::Audio },
+};
+
+static inline char mod_rate_tag(ModRate r) {
+    return r == ModRate::Audio ? 'a' : r == ModRate::Control ? 'k' : 'b';
+}
+
+// One-pole coefficient equivalent to `n` steps of a per-sample coefficient
+static inline float krate_coeff(float perSample, uint32_t n) {
+    return 1.0f - powf(1.0f - perSample, float(n));
+}
+
+// k-rate value ramped linearly to audio rate
+struct KRateLine {
+    float value = 0.0f;
+    float step = 0.0f;
+};
+
+static inline void krate_line_reset(KRateLine& l, float value) {
+    l.value = value;
+    l.step = 0.0f;
+}
+
+// Arrive at `target` after `n` ticks
+static inline void krate_line_set(KRateLine& l, float target, uint32_t n) {
+    l.step = (target - l.value) / float(n);
+}
+
+static inline float krate_line_tick(KRateLine& l) {
+    l.value += l.step;
+    return l.value;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ------------------------------
+// Power-of-two delay line with block read/write kernels
+// ------------------------------
+//
+// Indices wrap with a mask, so the cost per sample does not depend on the
+// delay length. A block is read before it is written, so every tap must be
+// at least `n + 3` frames back (the cubic kernel looks two samples ahead).
+
+struct DelayLine {
+    std::vector<float> buf;
+    uint32_t mask = 0;
+    uint32_t pos = 0; // next write index (unmasked, wraps naturally)
+};
+
+static inline void delay_init(DelayLine& d, uint32_t minFrames) {
+    uint32_t size = 1;
+    while (size < minFrames) size <<= 1;
+    d.buf.assign(size, 0.0f);
+    d.mask = size - 1;
+    d.pos = 0;
+}
+
+static inline void delay_clear(DelayLine& d) {
+    std::fill(d.buf.begin(), d.buf.end(), 0.0f);
+}
+
+static inline void delay_write_block(DelayLine& d, const float* in, uint32_t n) {
+    const uint32_t start = d.pos & d.mask;
+    const uint32_t first = std::min(n, d.mask + 1 - start);
+    memcpy(&d.buf[start], in, first * sizeof(float));
+    if (first < n) memcpy(&d.buf[0], in + first, (n - first) * sizeof(float));
+    d.pos += n;
+}
+
+// out[i] = x[pos + i - delay], integer delay
+static inline void delay_read_block(const DelayLine& d, uint32_t delay, float* out, uint32_t n) {
+    const uint32_t start = (d.pos - delay) & d.mask;
+    const uint32_t first = std::min(n, d.mask + 1 - start);
+    memcpy(out, &d.buf[start], first * sizeof(float));
+    if (first < n) memcpy(out + first, &d.buf[0], (n - first) * sizeof(float));
+}
+
+// out[i] = x[pos + i - delays[i]], fractional delays, cubic Hermite
+static inline void delay_read_block_interp(const DelayLine& d, const float* delays, float* out, uint32_t n) {
+    const float* b = d.buf.data();
+    const uint32_t m = d.mask;
+    for (uint32_t i = 0; i < n; ++i) {
+        // Split into whole + fraction; stays in integer index space
+        const uint32_t whole = uint32_t(delays[i]);
+        const float f = 1.0f - (delays[i] - float(whole));
+        const uint32_t j = d.pos + i - whole - 1;
+        const float xm1 = b[(j - 1) & m], x0 = b[j & m], x1 = b[(j + 1) & m], x2 = b[(j + 2) & m];
+        const float c1 = 0.5f * (x1 - xm1);
+        const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+        const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+        out[i] = ((c3 * f + c2) * f + c1) * f + x0;
+    }
+}
@@ -0,0 +1,285 @@
+#pragma once
+#include <windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// ------------------------------
+// Disk writers for the recorder: unbuffered/overlapped and plain buffered,
+// and the matching unbuffered reader for modulator and sample files
+// ------------------------------
+//
+// The unbuffered writer bypasses the file cache (FILE_FLAG_NO_BUFFERING), so
+// a long take does not evict everything else. It keeps several large
+// sector-aligned writes in flight (FILE_FLAG_OVERLAPPED) from a single
+// thread. Buffers come from VirtualAlloc and are page aligned. Every write
+// is one whole chunk at a chunk-aligned offset. On close, the last partial
+// chunk is padded to a sector, the header sector is rewritten in place, and
+// the file is trimmed to its real length. The reader streams a file
+// through the same slots, chunks handed back in order while the next ones
+// are already in flight.
+
+static constexpr uint32_t kDiskSector = 4096;     // covers 512e and 4Kn drives
+static constexpr uint32_t kDiskChunk = 1u << 20;  // bytes per write
+static constexpr int      kDiskSlots = 4;         // writes in flight
+
+struct DiskSlot {
+    OVERLAPPED ov;
+    uint8_t*   buf = nullptr;
+    bool       busy = false;
+};
+
+struct UnbufferedWriter {
+    HANDLE   file = INVALID_HANDLE_VALUE;
+    std::wstring path;
+    DiskSlot slot[kDiskSlots];
+    int      cur = 0;
+    uint32_t fill = 0;          // bytes staged in slot[cur]
+    uint64_t offset = 0;        // file offset of slot[cur]
+    uint64_t bytes = 0;         // total appended
+    uint32_t writes = 0;        // WriteFile calls issued
+    bool     failed = false;
+};
+
+static inline void disk_slot_wait(UnbufferedWriter& w, int i) {
+    DiskSlot& s = w.slot[i];
+    if (!s.busy) return;
+    DWORD done = 0;
+    if (!GetOverlappedResult(w.file, &s.ov, &done, TRUE)) w.failed = true;
+    s.busy = false;
+}
+
+static inline void disk_writer_release(UnbufferedWriter& w) {
+    for (DiskSlot& s : w.slot) {
+        if (s.ov.hEvent) { CloseHandle(s.ov.hEvent); s.ov.hEvent = nullptr; }
+        if (s.buf) { VirtualFree(s.buf, 0, MEM_RELEASE); s.buf = nullptr; }
+        s.busy = false;
+    }
+    if (w.file != INVALID_HANDLE_VALUE) { CloseHandle(w.file); w.file = INVALID_HANDLE_VALUE; }
+}
+
+static inline bool disk_writer_open(UnbufferedWriter& w, const wchar_t* path) {
+    w.file = CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED, nullptr);
+    if (w.file == INVALID_HANDLE_VALUE) return false;
+    w.path = path;
+    for (DiskSlot& s : w.slot) {
+        memset(&s.ov, 0, sizeof(s.ov));
+        s.ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        s.buf = static_cast<uint8_t*>(VirtualAlloc(nullptr, kDiskChunk, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        s.busy = false;
+        if (!s.ov.hEvent || !s.buf) { disk_writer_release(w); return false; }
+    }
+    w.cur = 0;
+    w.fill = 0;
+    w.offset = 0;
+    w.bytes = 0;
+    w.writes = 0;
+    w.failed = false;
+    return true;
+}
+
+// Queue slot[cur] (padded to whole sectors) and move to the next slot
+static inline void disk_submit(UnbufferedWriter& w) {
+    DiskSlot& s = w.slot[w.cur];
+    const uint32_t size = (w.fill + kDiskSector - 1) & ~(kDiskSector - 1);
+    memset(s.buf + w.fill, 0, size - w.fill);
+    s.ov.Offset = DWORD(w.offset);
+    s.ov.OffsetHigh = DWORD(w.offset >> 32);
+    ResetEvent(s.ov.hEvent);
+    if (!WriteFile(w.file, s.buf, size, nullptr, &s.ov) && GetLastError() != ERROR_IO_PENDING)
+        w.failed = true;
+    else
+        s.busy = true;
+    ++w.writes;
+    w.offset += size;
+    w.cur = (w.cur + 1) % kDiskSlots;
+    w.fill = 0;
+    disk_slot_wait(w, w.cur); // only blocks when all slots are in flight
+}
+
+static inline void disk_writer_append(UnbufferedWriter& w, const void* data, size_t n) {
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    w.bytes += n;
+    while (n > 0) {
+        const uint32_t take = uint32_t(std::min<size_t>(n, kDiskChunk - w.fill));
+        memcpy(w.slot[w.cur].buf + w.fill, src, take);
+        w.fill += take;
+        src += take;
+        n -= take;
+        if (w.fill == kDiskChunk) disk_submit(w);
+    }
+}
+
+// Flush, optionally rewrite the first `headerBytes` (a multiple of the
+// sector size) with final contents, trim to the real length and close.
+static inline bool disk_writer_close(UnbufferedWriter& w, const void* header, uint32_t headerBytes) {
+    if (w.file == INVALID_HANDLE_VALUE) return false;
+    if (w.fill > 0) disk_submit(w);
+    for (int i = 0; i < kDiskSlots; ++i) disk_slot_wait(w, i);
+
+    if (header && headerBytes) {
+        DiskSlot& s = w.slot[0];
+        memcpy(s.buf, header, headerBytes);
+        s.ov.Offset = 0;
+        s.ov.OffsetHigh = 0;
+        ResetEvent(s.ov.hEvent);
+        if (!WriteFile(w.file, s.buf, headerBytes, nullptr, &s.ov) && GetLastError() != ERROR_IO_PENDING)
+            w.failed = true;
+        else
+            s.busy = true;
+        disk_slot_wait(w, 0);
+    }
+    const uint64_t length = w.bytes;
+    disk_writer_release(w);
+
+    // Padding past the end is cut through a buffered handle
+    HANDLE h = CreateFileW(w.path.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER end;
+        end.QuadPart = LONGLONG(length);
+        SetFilePointerEx(h, end, nullptr, FILE_BEGIN);
+        SetEndOfFile(h);
+        CloseHandle(h);
+    }
+    return !w.failed;
+}
+
+// Plain cached writer with one synchronous WriteFile per append
+struct BufferedWriter {
+    HANDLE   file = INVALID_HANDLE_VALUE;
+    uint64_t bytes = 0;
+    uint32_t writes = 0;
+    bool     failed = false;
+};
+
+static inline bool buffered_writer_open(BufferedWriter& w, const wchar_t* path) {
+    w.file = CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    w.bytes = 0;
+    w.writes = 0;
+    w.failed = false;
+    return w.file != INVALID_HANDLE_VALUE;
+}
+
+static inline void buffered_writer_append(BufferedWriter& w, const void* data, size_t n) {
+    DWORD wrote = 0;
+    if (!WriteFile(w.file, data, DWORD(n), &wrote, nullptr) || wrote != n) w.failed = true;
+    w.bytes += n;
+    ++w.writes;
+}
+
+static inline bool buffered_writer_close(BufferedWriter& w) {
+    if (w.file == INVALID_HANDLE_VALUE) return false;
+    FlushFileBuffers(w.file);
+    CloseHandle(w.file);
+    w.file = INVALID_HANDLE_VALUE;
+    return !w.failed;
+}
+
+// ------------------------------
+// Unbuffered overlapped reader
+// ------------------------------
+
+struct UnbufferedReader {
+    HANDLE   file = INVALID_HANDLE_VALUE;
+    DiskSlot slot[kDiskSlots];
+    int      cur = 0;           // next slot handed out
+    int      held = -1;         // slot the caller is reading, resubmitted next call
+    uint64_t size = 0;          // file length
+    uint64_t issued = 0;        // file offset of the next read to queue
+    uint64_t offset = 0;        // file offset of slot[cur]
+    uint32_t reads = 0;         // ReadFile calls issued
+    bool     failed = false;
+};
+
+static inline void disk_reader_release(UnbufferedReader& r) {
+    for (DiskSlot& s : r.slot) {
+        if (s.busy) { CancelIoEx(r.file, &s.ov); DWORD n; GetOverlappedResult(r.file, &s.ov, &n, TRUE); }
+        if (s.ov.hEvent) { CloseHandle(s.ov.hEvent); s.ov.hEvent = nullptr; }
+        if (s.buf) { VirtualFree(s.buf, 0, MEM_RELEASE); s.buf = nullptr; }
+        s.busy = false;
+    }
+    if (r.file != INVALID_HANDLE_VALUE) { CloseHandle(r.file); r.file = INVALID_HANDLE_VALUE; }
+}
+
+// Queue one whole chunk into slot i; the read past the end comes back short
+static inline void disk_read_submit(UnbufferedReader& r, int i) {
+    DiskSlot& s = r.slot[i];
+    if (r.issued >= r.size) return;
+    s.ov.Offset = DWORD(r.issued);
+    s.ov.OffsetHigh = DWORD(r.issued >> 32);
+    ResetEvent(s.ov.hEvent);
+    if (!ReadFile(r.file, s.buf, kDiskChunk, nullptr, &s.ov) && GetLastError() != ERROR_IO_PENDING)
+        r.failed = true;
+    else
+        s.busy = true;
+    ++r.reads;
+    r.issued += kDiskChunk;
+}
+
+static inline bool disk_reader_open(UnbufferedReader& r, const wchar_t* path) {
+    r.file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (r.file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(r.file, &size)) { disk_reader_release(r); return false; }
+    r.size = uint64_t(size.QuadPart);
+    r.cur = 0;
+    r.held = -1;
+    r.issued = 0;
+    r.offset = 0;
+    r.reads = 0;
+    r.failed = false;
+    for (DiskSlot& s : r.slot) {
+        memset(&s.ov, 0, sizeof(s.ov));
+        s.ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        s.buf = static_cast<uint8_t*>(VirtualAlloc(nullptr, kDiskChunk, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        s.busy = false;
+        if (!s.ov.hEvent || !s.buf) { disk_reader_release(r); return false; }
+    }
+    for (int i = 0; i < kDiskSlots; ++i) disk_read_submit(r, i);
+    return true;
+}
+
+// Next chunk in file order; `data` stays valid until the following call.
+// False at the end of the file or on a failed read.
+static inline bool disk_reader_next(UnbufferedReader& r, const uint8_t*& data, uint32_t& bytes) {
+    if (r.held >= 0) { disk_read_submit(r, r.held); r.held = -1; }
+    if (r.failed || r.offset >= r.size) return false;
+    DiskSlot& s = r.slot[r.cur];
+    DWORD got = 0;
+    if (!s.busy || !GetOverlappedResult(r.file, &s.ov, &got, TRUE)) r.failed = true;
+    s.busy = false;
+    const uint32_t want = uint32_t(std::min<uint64_t>(kDiskChunk, r.size - r.offset));
+    if (r.failed || got < want) { r.failed = true; return false; }
+    data = s.buf;
+    bytes = want;
+    r.held = r.cur;
+    r.cur = (r.cur + 1) % kDiskSlots;
+    r.offset += want;
+    return true;
+}
+
+static inline bool disk_reader_close(UnbufferedReader& r) {
+    const bool ok = !r.failed;
+    disk_reader_release(r);
+    return ok;
+}
+
+// Whole file into memory through the reader (at most `limit` bytes)
+static inline bool disk_read_file(const wchar_t* path, std::vector<uint8_t>& bytes, uint64_t limit = 1ull << 30) {
+    UnbufferedReader r;
+    if (!disk_reader_open(r, path)) return false;
+    if (r.size == 0 || r.size >= limit) { disk_reader_release(r); return false; }
+    bytes.resize(size_t(r.size));
+    size_t at = 0;
+    const uint8_t* data = nullptr;
+    uint32_t n = 0;
+    while (disk_reader_next(r, data, n)) {
+        memcpy(bytes.data() + at, data, n);
+        at += n;
+    }
+    return disk_reader_close(r) && at == bytes.size();
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// ------------------------------
+// Waveforms
+// ------------------------------
+
+static constexpr float kTwoPi = 6.28318530717958647692f;
+
+static inline float fast_tanhf(float x) {
+    // Rational tanh approximation (sufficient for gentle waveshaping)
+    // tanh(x) ~ x * (27 + x^2) / (27 + 9*x^2)
+    const float x2 = x * x;
+    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+}
+
+// PolyBLEP-free soft saw/tri hybrid (simple, slightly band-limited by saturation)
+static inline float soft_saw(float phase) {
+    // Map phase to (-1..1) saw, then gently saturate
+    float s = (phase / kTwoPi) * 2.0f - 1.0f; // -1..1 ramp
+    return fast_tanhf(0.8f * s);
+}
+
+static inline float soft_tri(float phase) {
+    float tri = 2.0f * fabsf((phase / kTwoPi) - 0.5f) - 1.0f;
+    return fast_tanhf(0.8f * tri);
+}
+
+static inline float sine(float phase) {
+    return sinf(phase);
+}
+
+static inline float white_noise(uint32_t& seed) {
+    // Simple LCG-based white noise; deterministic enough for demo
+    seed = 1664525u * seed + 1013904223u;
+    const float u = (seed & 0x00FFFFFFu) / 16777216.0f; // [0,1)
+    return 2.0f * u - 1.0f; // [-1,1]
+}
+
+// ------------------------------
+// Voice chains: DSP stages composed at compile time
+// ------------------------------
+//
+// A chain lists its stages as template arguments, e.g.
+// Chain<Osc<Sine>, Drive, Noise, Shaper<Tanh>>. Each stage's tick() takes
+// the previous stage's sample and Chain::tick nests the calls, so once
+// inlined the whole chain is a single expression inside the caller's loop:
+// no virtual calls, no per-sample switch, no intermediate buffers. Drivers
+// copy the chain into a local for the block, so stage state (noise seeds,
+// levels) lives in registers and is stored back once.
+
+// What every stage can see for the current sample
+struct VoiceFrame {
+    float phaseA = 0.0f;  // main oscillator, radians
+    float phaseB = 0.0f;  // partner oscillator (~2x), radians
+};
+
+// Waves and curves
+struct Sine   { static float at(float phase) { return sine(phase); } };
+struct SawTri { static float at(float phase) { return 0.6f * soft_saw(phase) + 0.4f * soft_tri(phase); } };
+struct Tanh   { static float at(float x) { return fast_tanhf(x); } };
+
+// Stages
+template <class Wave> struct Osc {  // source: the main oscillator
+    float tick(const VoiceFrame& f, float) const { return Wave::at(f.phaseA); }
+};
+
+template <class Wave> struct Ring {  // ring modulation by the partner, mixed with the input
+    float dry = 0.70f, wet = 0.45f;
+    float tick(const VoiceFrame& f, float x) const { return dry * x + wet * (x * Wave::at(f.phaseB)); }
+};
+
+struct Drive {
+    float k = 0.85f;
+    float tick(const VoiceFrame&, float x) const { return k * x; }
+};
+
+struct Noise {
+    float    amount = 0.25f;
+    uint32_t seed = 0x12345678u;
+    float tick(const VoiceFrame&, float x) { return x + amount * white_noise(seed); }
+};
+
+template <class Curve> struct Shaper {
+    float tick(const VoiceFrame&, float x) const { return Curve::at(x); }
+};
+
+template <class... Stages> struct Chain;
+
+template <> struct Chain<> {
+    float tick(const VoiceFrame&, float x) { return x; }
+};
+
+template <class Head, class... Tail> struct Chain<Head, Tail...> {
+    Head           head;
+    Chain<Tail...> tail;
+    float tick(const VoiceFrame& f, float x) { return tail.tick(f, head.tick(f, x)); }
+};
+
+// Fixed-pitch driver: both phases advance by a constant step
+template <class C>
+static inline void chain_run(C& chain, VoiceFrame& frame, float incA, float incB, float* out, uint32_t frames) {
+    C c = chain;
+    VoiceFrame f = frame;
+    for (uint32_t i = 0; i < frames; ++i) {
+        f.phaseA += incA;
+        if (f.phaseA >= kTwoPi) f.phaseA -= kTwoPi;
+        f.phaseB += incB;
+        if (f.phaseB >= kTwoPi) f.phaseB -= kTwoPi;
+        out[i] = c.tick(f, 0.0f);
+    }
+    frame = f;
+    chain = c;
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "SimdMath.h"
+
+// ------------------------------
+// Dynamics: stereo-linked compressor + downward expander/gate
+// ------------------------------
+//
+// Works on the 4-lane output bus (lane 0 = L, lane 1 = R). One detector is
+// shared by all lanes so the stereo image never shifts. Rectification and
+// the gain computer are SIMD; only the attack/release recursion is scalar.
+
+static constexpr uint32_t kDynDelayFrames = 1024; // look-ahead ring (power of two)
+static constexpr uint32_t kDynChunk = 64;         // detector scratch size (multiple of 4)
+static constexpr float    kDynFadeMs = 5.0f;      // on/off crossfade with the undelayed signal
+
+struct DynamicsParams {
+    std::atomic<bool>  enabled{ false };
+    std::atomic<bool>  rmsDetect{ true };          // RMS (true) or peak detector
+    std::atomic<float> thresholdDb{ -18.0f };      // compressor
+    std::atomic<float> ratio{ 3.0f };
+    std::atomic<float> kneeDb{ 6.0f };
+    std::atomic<float> attackMs{ 5.0f };
+    std::atomic<float> releaseMs{ 120.0f };
+    std::atomic<float> makeupDb{ 0.0f };
+    std::atomic<float> gateThresholdDb{ -55.0f };  // expander/gate
+    std::atomic<float> gateRatio{ 4.0f };          // 1 = off; >= 20 acts as a gate
+    std::atomic<float> gateRangeDb{ -60.0f };      // deepest expander attenuation
+    std::atomic<float> lookaheadMs{ 2.0f };
+    std::atomic<float> gainReductionDb{ 0.0f };    // meter: deepest gain in the last block (audio thread)
+};
+
+struct DynamicsState {
+    __m128   delay[kDynDelayFrames];
+    uint32_t delayPos = 0;
+    float    env = 0.0f; // detector state: linear peak or mean square
+    float    mix = 0.0f; // 0 = undelayed input, 1 = delayed and compressed
+    uint32_t filled = 0; // frames in the ring since switching on
+    bool     active = false;
+    alignas(16) float scratch[kDynChunk];
+};
+
+static inline void dynamics_reset(DynamicsState& s) {
+    memset(s.delay, 0, sizeof(s.delay));
+    s.delayPos = 0;
+    s.env = 0.0f;
+    s.mix = 0.0f;
+    s.filled = 0;
+}
+
+// Static curve in dB (SIMD): soft-knee compression above `thr`, downward
+// expansion below `gateThr`, clamped to `range`.
+static inline __m128 dynamics_gain_db(__m128 lvl, float thr, float slope, float knee,
+                                      float gateThr, float gateSlope, float range, float makeup) {
+    // Quadratic knee written branch-free:
+    //   y = clamp(over + W/2, 0, W);  gc = slope * (y^2 / 2W + max(over - W/2, 0))
+    const __m128 over = _mm_sub_ps(lvl, _mm_set1_ps(thr));
+    const __m128 halfW = _mm_set1_ps(0.5f * knee);
+    const __m128 y = _mm_min_ps(_mm_max_ps(_mm_add_ps(over, halfW), _mm_setzero_ps()), _mm_set1_ps(knee));
+    const __m128 lin = _mm_max_ps(_mm_sub_ps(over, halfW), _mm_setzero_ps());
+    const __m128 gc = _mm_mul_ps(_mm_set1_ps(slope),
+        _mm_add_ps(_mm_mul_ps(_mm_mul_ps(y, y), _mm_set1_ps(0.5f / knee)), lin));
+
+    const __m128 under = _mm_min_ps(_mm_sub_ps(lvl, _mm_set1_ps(gateThr)), _mm_setzero_ps());
+    const __m128 ge = _mm_max_ps(_mm_mul_ps(_mm_set1_ps(gateSlope), under), _mm_set1_ps(range));
+
+    return _mm_add_ps(_mm_add_ps(gc, ge), _mm_set1_ps(makeup));
+}
+
+// Switching on or off crossfades between the input and the delayed,
+// compressed signal over kDynFadeMs, so the look-ahead delay neither drops
+// audio nor clicks. Switching on starts the fade once the ring holds the
+// look-ahead; until then the input passes through.
+static inline void dynamics_process(DynamicsState& s, DynamicsParams& p, float* lanes, uint32_t frames, float sampleRate) {
+    const bool on = p.enabled.load(std::memory_order_relaxed);
+    if (!on && !s.active) return;
+    if (on && !s.active) { dynamics_reset(s); s.active = true; }
+
+    // Per-block parameter snapshot
+    const bool  rms = p.rmsDetect.load(std::memory_order_relaxed);
+    const float thr = p.thresholdDb.load(std::memory_order_relaxed);
+    const float ratio = std::fmax(1.0f, p.ratio.load(std::memory_order_relaxed));
+    const float knee = std::fmax(0.01f, p.kneeDb.load(std::memory_order_relaxed));
+    const float makeup = p.makeupDb.load(std::memory_order_relaxed);
+    const float gateThr = p.gateThresholdDb.load(std::memory_order_relaxed);
+    const float gateRatio = std::fmax(1.0f, p.gateRatio.load(std::memory_order_relaxed));
+    const float range = std::fmin(0.0f, p.gateRangeDb.load(std::memory_order_relaxed));
+    const float atkS = std::fmax(0.05f, p.attackMs.load(std::memory_order_relaxed)) * 0.001f;
+    const float relS = std::fmax(1.0f, p.releaseMs.load(std::memory_order_relaxed)) * 0.001f;
+    const float aAtt = expf(-1.0f / (atkS * sampleRate));
+    const float aRel = expf(-1.0f / (relS * sampleRate));
+    const float slope = 1.0f / ratio - 1.0f;
+    const float gateSlope = gateRatio - 1.0f;
+    const uint32_t look = std::min(kDynDelayFrames - 1,
+        uint32_t(p.lookaheadMs.load(std::memory_order_relaxed) * 0.001f * sampleRate));
+    // Mean square -> dB is 10*log10, peak -> dB is 20*log10
+    const __m128 toDb = _mm_set1_ps(rms ? 0.5f * kDbPerLog2 : kDbPerLog2);
+
+    const float fade = (on ? 1000.0f : -1000.0f) / (kDynFadeMs * sampleRate);
+
+    const __m128 half = _mm_set1_ps(0.5f);
+    float minGain = 1.0f;
+    float* g = s.scratch;
+
+    for (uint32_t base = 0; base < frames; base += kDynChunk) {
+        const uint32_t n = std::min(kDynChunk, frames - base);
+        float* chunk = lanes + 4 * base;
+
+        // Stereo-linked rectification (lane 0 receives the linked level)
+        for (uint32_t i = 0; i < n; ++i) {
+            const __m128 v = _mm_load_ps(chunk + 4 * i);
+            __m128 d;
+            if (rms) {
+                const __m128 sq = _mm_mul_ps(v, v);
+                d = _mm_mul_ps(_mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1))), half);
+            } else {
+                const __m128 a = abs_ps(v);
+                d = _mm_max_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+            }
+            _mm_store_ss(g + i, d);
+        }
+
+        // Attack/release ballistics (the only serial part)
+        float env = s.env;
+        for (uint32_t i = 0; i < n; ++i) {
+            const float d = g[i];
+            const float a = d > env ? aAtt : aRel;
+            env = d + a * (env - d);
+            g[i] = env;
+        }
+        s.env = env;
+        for (uint32_t i = n; i < ((n + 3) & ~3u); ++i) g[i] = env;
+
+        // Gain computer in the log domain, four detector samples at a time
+        __m128 vmin = _mm_set1_ps(1.0f);
+        for (uint32_t i = 0; i < n; i += 4) {
+            const __m128 lvl = _mm_mul_ps(fast_log2_ps(_mm_max_ps(_mm_load_ps(g + i), _mm_set1_ps(1e-12f))), toDb);
+            const __m128 gdb = dynamics_gain_db(lvl, thr, slope, knee, gateThr, gateSlope, range, makeup);
+            const __m128 lin = fast_exp2_ps(_mm_mul_ps(gdb, _mm_set1_ps(kLog2PerDb)));
+            vmin = _mm_min_ps(vmin, lin);
+            _mm_store_ps(g + i, lin);
+        }
+        alignas(16) float m4[4];
+        _mm_store_ps(m4, vmin);
+        minGain = std::fmin(minGain, std::fmin(std::fmin(m4[0], m4[1]), std::fmin(m4[2], m4[3])));
+
+        // Look-ahead: the gain is applied to audio delayed by `look` frames
+        uint32_t pos = s.delayPos;
+        if (on && s.mix == 1.0f) {
+            for (uint32_t i = 0; i < n; ++i) {
+                s.delay[pos] = _mm_load_ps(chunk + 4 * i);
+                const __m128 x = s.delay[(pos - look) & (kDynDelayFrames - 1)];
+                _mm_store_ps(chunk + 4 * i, _mm_mul_ps(x, _mm_set1_ps(g[i])));
+                pos = (pos + 1) & (kDynDelayFrames - 1);
+            }
+        } else {
+            float mix = s.mix;
+            for (uint32_t i = 0; i < n; ++i) {
+                const __m128 in = _mm_load_ps(chunk + 4 * i);
+                s.delay[pos] = in;
+                const __m128 x = _mm_mul_ps(s.delay[(pos - look) & (kDynDelayFrames - 1)], _mm_set1_ps(g[i]));
+                if (s.filled < look) ++s.filled;
+                else mix = std::fmax(0.0f, std::fmin(1.0f, mix + fade));
+                _mm_store_ps(chunk + 4 * i, _mm_add_ps(in, _mm_mul_ps(_mm_set1_ps(mix), _mm_sub_ps(x, in))));
+                pos = (pos + 1) & (kDynDelayFrames - 1);
+            }
+            s.mix = mix;
+        }
+        s.delayPos = pos;
+    }
+
+    if (!on && s.mix == 0.0f) { // faded out
+        s.active = false;
+        p.gainReductionDb.store(0.0f, std::memory_order_relaxed);
+        return;
+    }
+    p.gainReductionDb.store(fast_gain_to_db(std::fmax(minGain, 1e-6f)) - makeup, std::memory_order_relaxed);
+}
@@ -0,0 +1,732 @@
+#pragma once
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "ParametricEq.h"
+#include "Dynamics.h"
+#include "Harmonizer.h"
+#include "Vocoder.h"
+#include "DelayLine.h"
+#include "TapeDelay.h"
+#include "Gesture.h"
+#include "GainStage.h"
+#include "ControlRate.h"
+#include "SpscRing.h"
+#include "ControlQueue.h"
+#include "VoicePool.h"
+#include "DspChain.h"
+#include "Epoch.h"
+
+// ------------------------------
+// Synth engine: one instance holds everything the voice and chain need
+// ------------------------------
+//
+// No globals: parameters, render state, gesture filters and the control
+// queue all live in an Engine, so a process can run several. The app owns
+// one; the C API (TheraminApi.h) creates them for other hosts. All memory
+// is allocated by engine_init; rendering only touches what it owns plus the
+// optional taps the host points it at.
+
+static constexpr float kSampleRate = 48000.0f;
+static constexpr float kMinHz = 100.0f;           // default pitch range
+static constexpr float kMaxHz = 2000.0f;
+static constexpr float kHzSmoothCoeff = 0.05f;    // fixed frequency slew (adaptive off)
+static constexpr float kGainSmoothCoeff = 0.075f; // fixed amplitude slew
+static constexpr uint32_t kBlockFrames = 128; // render granularity for the output chain
+
+// Playing-surface settings that change together (a config reload). The
+// render thread reads them through Engine::config, swapped whole.
+struct EngineConfig {
+    float minHz = kMinHz, maxHz = kMaxHz;    // pitch axis range
+    float pitchCurve = 1.0f;                 // exponent on x before the log mapping
+    float gainCurve = 1.0f;                  // exponent on the volume axis
+    float hzSmooth = kHzSmoothCoeff;         // fixed slews (adaptive off)
+    float gainSmooth = kGainSmoothCoeff;
+};
+static const EngineConfig kEngineDefaults{};
+
+// Modes 1..4 as voice chains
+using VoiceMode1 = Chain<Osc<Sine>>;                             // pure sine
+using VoiceMode2 = Chain<Osc<Sine>, Ring<Sine>>;                 // sine + ring modulation
+using VoiceMode3 = Chain<Osc<Sine>, Drive, Noise, Shaper<Tanh>>; // airy: sine + noise + gentle saturation
+using VoiceMode4 = Chain<Osc<SawTri>>;                           // soft saw/tri hybrid
+
+struct VoiceChains {
+    VoiceMode1 mode1;
+    VoiceMode2 mode2;
+    VoiceMode3 mode3;
+    VoiceMode4 mode4;
+};
+
+struct SynthParams {
+    std::atomic<float> targetHz{ 440.0f };
+    std::atomic<float> targetGain{ 0.0f };   // 0..1
+    std::atomic<int>   mode{ 1 };            // 1..4
+    std::atomic<bool>  mute{ false };
+    std::atomic<float> vibratoDepth{ 0.0f }; // 0..1 (depth scaled in synth)
+    std::atomic<int>   controlFrames{ int(kControlFrames) }; // k-rate period (1 = audio rate)
+    std::atomic<bool>  adaptiveSmoothing{ true }; // slew cutoffs follow gesture speed
+    std::atomic<float> hzCutoff{ 400.0f };   // Hz, published per control event
+    std::atomic<float> gainCutoff{ 400.0f };
+    std::atomic<bool>  predictGesture{ false };   // extrapolate to playback time
+    std::atomic<bool>  fusedOutput{ true };       // single-pass fast path for the common chain
+    GestureSnapshot    gesture;               // predictor output, per control event
+    GainParams         gain;                  // master level, per-mode trim, mute ramp
+    EqParams           eq;                    // output EQ (room correction)
+    DynamicsParams     dyn;                   // output compressor/gate
+    HarmonizerParams   harm;                  // pitch-shifted harmony voices
+    VocoderParams      voc;                   // channel vocoder (voice = carrier)
+    TapeDelayParams    tape;                  // echo; replaces the crossfeed when on
+    ChordParams        chord;                 // chord / arpeggio pool voices
+};
+
+struct SynthState {
+    float phaseA = 0.0f; // main osc
+    float phaseB = 0.0f; // mod osc
+    float smoothHz = 440.0f;
+    float vibratoPhase = 0.0f;
+    KRateLine pitch;                         // k-rate pitch (slew + vibrato), ramped
+    uint32_t controlCountdown = 0;           // samples left in the control period
+    DelayLine crossL, crossR;                // minimal stereo decorrelation
+    uint32_t crossDelay = 0;
+    uint64_t frameIndex = 0; // absolute position of the current block
+    uint64_t fusedBlocks = 0; // blocks that took the fused output path
+    CutoffCoeff hzSlew, gainSlew;
+    GainState gain;                          // voice gain (dB-smoothed, ramped)
+    double renderTime = 0.0; // NowSeconds() when this block is rendered, 0 = offline
+    double playTime = 0.0;   // when its first frame is expected at the speaker
+    EqState eq;
+    DynamicsState dyn;
+    HarmonizerState harm;
+    VocoderState voc;
+    ModulatorFeed mod;                       // vocoder modulator (capture or file)
+    TapeDelayState tape;
+    VoiceChains chains;                      // per-mode stage state
+    ChordState chord;                        // pool voices for chord and arpeggio
+    DroneBank drones;                        // latched voices
+    float droneGain = 0.0f;                  // mute/master/trim applied to drones last block
+    float droneBuf[kBlockFrames];
+    float voice[kBlockFrames];               // mono voice (post gain)
+    float modBlock[kBlockFrames];
+    float dryL[kBlockFrames], dryR[kBlockFrames];
+    float tapL[kBlockFrames], tapR[kBlockFrames];
+    alignas(16) float bus[kBlockFrames * 4]; // 4-lane output frames (L, R, -, -)
+    float stereo[kBlockFrames * 2];          // post-chain L/R for the analysis tap
+};
+
+// One-pole smoother (slew) for frequency and gain
+static inline float smooth_step(float current, float target, float coeff) {
+    return current + coeff * (target - current);
+}
+
+// Map normalised X (0..1) to logarithmic frequency between minHz and maxHz
+static inline float map_nx_to_hz(const EngineConfig& c, float nx) {
+    nx = std::max(0.0f, std::min(1.0f, nx));
+    if (c.pitchCurve != 1.0f) nx = powf(nx, c.pitchCurve);
+    // Log mapping: Hz = Min * (Max/Min)^nx
+    float ratio = c.maxHz / c.minHz;
+    return c.minHz * powf(ratio, nx);
+}
+
+// Inverse, for drawing: where on the pitch axis `hz` sits (may be outside 0..1)
+static inline float map_hz_to_nx(const EngineConfig& c, float hz) {
+    const float u = logf(hz / c.minHz) / logf(c.maxHz / c.minHz);
+    return c.pitchCurve != 1.0f && u > 0.0f ? powf(u, 1.0f / c.pitchCurve) : u;
+}
+
+// Map normalised Y (0..1) to gain (top loud, bottom quiet)
+static inline float map_ny_to_gain(const EngineConfig& c, float ny) {
+    ny = std::max(0.0f, std::min(1.0f, ny));
+    const float g = 1.0f - ny; // invert (top loud)
+    return c.gainCurve != 1.0f ? powf(g, c.gainCurve) : g;
+}
+
+// Stem takes: records of [take id, payload size, payload], one planar
+// record per render block (channel after channel)
+static constexpr uint32_t kRecordHeader = 2;
+
+enum StemChannel {
+    kStemVoice, kStemHarm1, kStemHarm2, kStemDryL, kStemDryR, kStemFxL, kStemFxR, kStemMixL, kStemMixR,
+    kStemChannels
+};
+
+static inline uint32_t StemOffset(int channel, uint32_t frames) {
+    return kRecordHeader + uint32_t(channel) * frames;
+}
+
+// Gesture conditioning (pitch axis, volume axis), run as control events
+// are drained on the audio thread
+struct GestureFilters {
+    AdaptiveSmoother x, y;
+    GesturePredictor px, py;
+    float nx = 0.5f, ny = 1.0f;   // current position (relative motion integrates here)
+    float vibrato[kControlSources] = {}; // depth per source; the deepest wins
+    double filteredT = -1.0e9;     // time of the last move through the filters
+};
+static constexpr float kPredictTolerance = 0.04f; // innovation (window widths) that zeroes confidence
+static constexpr double kControlMergeSec = 0.001; // closer moves reach the filters as one
+
+struct Engine {
+    SynthParams    params;      // any thread
+    SynthState     synth;       // render thread
+    GestureFilters gesture;     // render thread, as control events drain
+    ControlQueue   control;     // every input source pushes here
+    EpochDomain    reclaim;     // objects swapped out under the render thread
+    std::atomic<EngineConfig*> config{ nullptr }; // null = kEngineDefaults
+
+    ~Engine() { delete config.load(); }
+
+    // Optional taps, set by the host on the render thread between blocks
+    SpscRing*      analysisTap = nullptr;  // post-chain stereo frames
+    SpscRing*      stemTap = nullptr;      // stem records (see StemChannel)
+    float          stemTake = 0.0f;        // take id stamped on stem records
+};
+
+// ------------------------------
+// Control events
+// ------------------------------
+
+// Freeze the live voice into a drone: its pitch (without vibrato), gesture
+// level and phase
+static inline void engine_latch(Engine& e, float sampleRate) {
+    SynthState& s = e.synth;
+    if (s.gain.db <= kGainFloorDb + 0.5f) return; // nothing sounding
+    drone_latch(s.drones, e.params.mode.load(), s.smoothHz, fast_db_to_gain(s.gain.db),
+        s.phaseA / kTwoPi, sampleRate);
+}
+
+// The position as of `t` through the adaptive slew and the predictor, then
+// out as new targets
+static inline void engine_move(Engine& engine, const EngineConfig& c, double t) {
+    SynthParams& p = engine.params;
+    GestureFilters& f = engine.gesture;
+    const float nx = f.nx, ny = f.ny;
+    // Adaptive slew: cutoffs follow gesture speed (log-pitch and gain axes)
+    p.hzCutoff.store(adaptive_cutoff(f.x, nx, t));
+    p.gainCutoff.store(adaptive_cutoff(f.y, ny, t));
+    // Predictor: position, velocity and confidence for the render
+    predictor_update(f.px, nx, t);
+    predictor_update(f.py, ny, t);
+    GestureSample g;
+    g.t = t;
+    g.x = f.px.x; g.vx = f.px.v; g.cx = predictor_confidence(f.px, kPredictTolerance);
+    g.y = f.py.x; g.vy = f.py.v; g.cy = predictor_confidence(f.py, kPredictTolerance);
+    gesture_publish(p.gesture, g);
+    p.targetHz.store(map_nx_to_hz(c, nx));
+    p.targetGain.store(map_ny_to_gain(c, ny));
+    f.filteredT = t;
+}
+
+// Once per host buffer, before rendering it: publish the render thread's
+// epoch, then apply queued input in arrival order. Each event moves the
+// position; moves less than kControlMergeSec after the last filtered one
+// only move it, and the newest of them goes through the filters (which are
+// tuned for input up to about 1 kHz) by the end of the drain.
+static inline void engine_drain(Engine& engine, float sampleRate) {
+    epoch_enter(engine.reclaim, kEpochRender);
+    SynthParams& p = engine.params;
+    GestureFilters& f = engine.gesture;
+    ControlQueue& q = engine.control;
+    const EngineConfig* cfg = engine.config.load();
+    const EngineConfig& c = cfg ? *cfg : kEngineDefaults;
+    const uint32_t waiting = control_pending(q);
+    if (waiting > q.peak.load(std::memory_order_relaxed)) q.peak.store(waiting, std::memory_order_relaxed);
+    double heldT = -1.0;  // a merged move not filtered yet (< 0: none)
+    uint32_t merged = 0;
+    ControlEvent e;
+    while (control_pop(q, e)) {
+        switch (e.type) {
+        case ControlType::Position:
+            f.nx = e.x;
+            f.ny = e.y;
+            break;
+        case ControlType::Motion:
+            f.nx = std::max(0.0f, std::min(1.0f, f.nx + e.x));
+            f.ny = std::max(0.0f, std::min(1.0f, f.ny + e.y));
+            break;
+        case ControlType::Gain:
+            f.ny = 1.0f - std::max(0.0f, std::min(1.0f, e.x));
+            break;
+        case ControlType::Vibrato: {
+            f.vibrato[int(e.source)] = e.x;
+            float depth = 0.0f;
+            for (float v : f.vibrato) depth = std::max(depth, v);
+            p.vibratoDepth.store(depth);
+            continue;
+        }
+        case ControlType::Latch:
+            engine_latch(engine, sampleRate);
+            continue;
+        case ControlType::Release:
+            drone_release(engine.synth.drones, e.x > 0.5f);
+            continue;
+        }
+        if (heldT >= 0.0) ++merged; // this move supersedes the held one
+        heldT = -1.0;
+        const double gap = e.t - f.filteredT; // < 0: another source's clock, or a restart
+        if (gap >= 0.0 && gap < kControlMergeSec) { heldT = e.t; continue; }
+        engine_move(engine, c, e.t);
+    }
+    if (heldT >= 0.0) engine_move(engine, c, heldT);
+    if (merged) q.coalesced.fetch_add(merged, std::memory_order_relaxed);
+}
+
+// ------------------------------
+// Rendering
+// ------------------------------
+
+// One cycle of each mode's waveform for drone playback. Mode 2's ring
+// partner is locked to exactly 2x and mode 3 drops its noise, so those
+// drones are steady versions of the live timbre.
+static inline void engine_build_drone_tables(DroneBank& b) {
+    for (uint32_t k = 0; k <= kDroneTable; ++k) {
+        const float ph = kTwoPi * float(k % kDroneTable) / float(kDroneTable);
+        const float a = sine(ph);
+        b.table[0][k] = a;
+        b.table[1][k] = 0.70f * a + 0.45f * a * sine(2.0f * ph);
+        b.table[2][k] = fast_tanhf(0.85f * a);
+        b.table[3][k] = 0.6f * soft_saw(ph) + 0.4f * soft_tri(ph);
+    }
+}
+
+// Allocates every buffer the engine uses and resets it to silence
+static inline void engine_init(Engine& e, float sampleRate) {
+    SynthState& s = e.synth;
+    // Delay line for subtle stereo decorrelation (block reads need >= 1 block)
+    s.crossDelay = std::max(kBlockFrames, uint32_t(sampleRate * 0.012f)); // 12 ms
+    delay_init(s.crossL, s.crossDelay + kBlockFrames);
+    delay_init(s.crossR, s.crossDelay + kBlockFrames);
+    tape_delay_init(s.tape, sampleRate);
+
+    krate_line_reset(s.pitch, s.smoothHz);
+    s.controlCountdown = 0;
+    gain_reset(s.gain);
+    eq_reset(s.eq);
+    dynamics_reset(s.dyn);
+    harmonizer_init(s.harm, sampleRate);
+    vocoder_reset(s.voc);
+    modulator_init(s.mod);
+    chord_init(s.chord);
+    engine_build_drone_tables(s.drones);
+    drone_reset(s.drones);
+    s.droneGain = 0.0f;
+    s.frameIndex = 0;
+}
+
+// Any thread but the render thread: swap in a new vocoder modulator file
+// (null for none). The old clip is freed here or by a later
+// engine_reclaim, once the render thread has moved past it.
+static inline void engine_set_modulator(Engine& e, ModulatorClip* clip) {
+    if (clip && clip->samples.empty()) { delete clip; clip = nullptr; }
+    epoch_retire(e.reclaim, e.synth.mod.clip.exchange(clip));
+    epoch_collect(e.reclaim);
+}
+
+// Any thread but the render thread: publish new playing-surface settings,
+// clamped to what the voice can play. The next block picks them up whole.
+static inline void engine_set_config(Engine& e, const EngineConfig& config) {
+    EngineConfig* c = new EngineConfig(config);
+    c->minHz = std::max(20.0f, std::min(4000.0f, c->minHz));
+    c->maxHz = std::max(c->minHz * 1.5f, std::min(12000.0f, c->maxHz));
+    c->pitchCurve = std::max(0.25f, std::min(4.0f, c->pitchCurve));
+    c->gainCurve = std::max(0.25f, std::min(4.0f, c->gainCurve));
+    c->hzSmooth = std::max(0.001f, std::min(1.0f, c->hzSmooth));
+    c->gainSmooth = std::max(0.001f, std::min(1.0f, c->gainSmooth));
+    epoch_retire(e.reclaim, e.config.exchange(c));
+    epoch_collect(e.reclaim);
+}
+
+// Any thread but the render thread, periodically: free retired objects
+static inline size_t engine_reclaim(Engine& e) {
+    return epoch_collect(e.reclaim);
+}
+
+// Base waveform of the pool voices for the current mode
+static inline float pool_wave(int mode, float phase) {
+    return mode == 4 ? 0.6f * soft_saw(phase) + 0.4f * soft_tri(phase) : sine(phase);
+}
+
+// Chord tones and the arpeggio, added to the block's voice before the gain
+// stage. They track the main voice's pitch across the block (glide and
+// vibrato): `hz0`/`hz1` are its pitch at the block's start and end.
+static inline void engine_pool_voices(Engine& e, ChordMode chordMode, int mode, float hz0, float hz1,
+    uint32_t frames, float sampleRate) {
+    ChordState& c = e.synth.chord;
+    const float* ratio = c.ratio[c.degree];
+    const float level = e.params.chord.level.load();
+    const float dt = 1.0f / sampleRate;
+    float* voice = e.synth.voice;
+
+    // Chord: each tone ramps pitch and level linearly over the block
+    for (int v = 0; v < kChordVoices; ++v) {
+        PoolVoice& p = c.tone[v];
+        const float target = chordMode == ChordMode::Chord ? level : 0.0f;
+        if (p.level == 0.0f && target == 0.0f) continue;
+        const float hzEnd = hz1 * ratio[v + 1];
+        const float hzStart = p.level > 0.0f ? p.hz : hz0 * ratio[v + 1];
+        const float dInc = kTwoPi * (hzEnd - hzStart) * dt / float(frames);
+        const float dLevel = (target - p.level) / float(frames);
+        float inc = kTwoPi * hzStart * dt, lvl = p.level;
+        for (uint32_t i = 0; i < frames; ++i) {
+            inc += dInc;
+            lvl += dLevel;
+            p.phase += inc;
+            if (p.phase >= kTwoPi) p.phase -= kTwoPi;
+            voice[i] += lvl * pool_wave(mode, p.phase);
+        }
+        p.hz = hzEnd;
+        p.level = target;
+    }
+
+    // Arpeggio: up through the chord an octave above, gated per step
+    PoolVoice& a = c.arp;
+    const bool arpOn = chordMode == ChordMode::Arp;
+    if (!arpOn) {
+        c.arpPos = 0;
+        c.arpStep = 0;
+        if (a.level == 0.0f) return;
+    }
+    const float stepsPerSec = e.params.tape.bpm.load() / 60.0f * e.params.chord.arpDivision.load();
+    const uint32_t stepLen = std::max(1u, uint32_t(sampleRate / std::max(0.1f, stepsPerSec)));
+    const uint32_t gateLen = uint32_t(float(stepLen) * std::min(0.95f, e.params.chord.arpGate.load()));
+    const float edge = level / std::max(1.0f, 0.002f * sampleRate); // 2 ms attack/release
+    const float dHz = (hz1 - hz0) / float(frames);
+    for (uint32_t i = 0; i < frames; ++i) {
+        if (c.arpPos >= stepLen) {
+            c.arpPos = 0;
+            c.arpStep = (c.arpStep + 1) % kChordTones;
+        }
+        const float target = arpOn && c.arpPos < gateLen ? level : 0.0f;
+        a.level = target > a.level ? std::min(target, a.level + edge) : std::max(target, a.level - edge);
+        a.phase += kTwoPi * (hz0 + dHz * float(i + 1)) * 2.0f * ratio[c.arpStep] * dt;
+        if (a.phase >= kTwoPi) a.phase -= kTwoPi;
+        voice[i] += a.level * pool_wave(mode, a.phase);
+        ++c.arpPos;
+    }
+}
+
+// The voice for one block: k-rate slew and vibrato, a-rate pitch ramp and
+// phases, then the mode's chain per sample into synth.voice, scaled by a
+// gain ramp from g0 to g1 (1 and 1 when the gain stage runs later). The
+// hot state is copied to locals for the block so it stays in registers.
+template <class C>
+static inline void engine_voice(Engine& e, C& chain, float tgtHz, float hzSmoothK, uint32_t ctlFrames,
+    float g0, float g1, uint32_t frames, float sampleRate) {
+    SynthState& s = e.synth;
+    const float dt = 1.0f / sampleRate;
+    GainRamp ramp = gain_ramp_begin(g0, g1, frames);
+    C c = chain;
+    VoiceFrame f;
+    f.phaseA = s.phaseA;
+    f.phaseB = s.phaseB;
+    KRateLine pitch = s.pitch;
+    uint32_t countdown = s.controlCountdown;
+    float* voice = s.voice;
+
+    for (uint32_t i = 0; i < frames; ++i) {
+        // k-rate: slew and vibrato, then ramp pitch to the new value
+        if (countdown == 0) {
+            float vibAmt = e.params.vibratoDepth.load();
+
+            s.smoothHz = smooth_step(s.smoothHz, tgtHz, hzSmoothK);
+
+            // Vibrato (5.5 Hz)
+            s.vibratoPhase += kTwoPi * 5.5f * dt * float(ctlFrames);
+            if (s.vibratoPhase >= kTwoPi) s.vibratoPhase -= kTwoPi;
+            float vibrato = (vibAmt > 0.0f) ? 0.01f * vibAmt * sinf(s.vibratoPhase) : 0.0f;
+
+            krate_line_set(pitch, s.smoothHz * (1.0f + vibrato), ctlFrames);
+            countdown = ctlFrames;
+        }
+        --countdown;
+
+        // a-rate from here on
+        float hz = krate_line_tick(pitch);
+        float incA = kTwoPi * hz * dt;
+        float incB = kTwoPi * (hz * 1.997f) * dt; // mod osc ~2x main
+
+        // Advance phases (each wrap of the main osc is a pitch mark)
+        f.phaseA += incA;
+        if (f.phaseA >= kTwoPi) {
+            f.phaseA -= kTwoPi;
+            harmonizer_mark(s.harm, s.frameIndex + i);
+        }
+        f.phaseB += incB;
+        if (f.phaseB >= kTwoPi) f.phaseB -= kTwoPi;
+
+        const float g = i + 1 == frames ? g1 : gain_ramp_next(ramp);
+        voice[i] = c.tick(f, 0.0f) * g;
+    }
+
+    s.phaseA = f.phaseA;
+    s.phaseB = f.phaseB;
+    s.pitch = pitch;
+    s.controlCountdown = countdown;
+    chain = c;
+}
+
+// The common chain is the voice, its gain, the crossfeed, the EQ and the
+// stereo output. Anything else that is on (or has not yet settled after
+// being switched off), or an EQ change still to be ramped in, needs the
+// generic multi-pass path.
+static inline bool engine_can_fuse(const Engine& e, ChordMode chordMode, int channels) {
+    const SynthState& s = e.synth;
+    const SynthParams& p = e.params;
+    return p.fusedOutput.load(std::memory_order_relaxed) && channels == 2 && !e.stemTap
+        && chordMode == ChordMode::Off && s.chord.arp.level == 0.0f && s.chord.tone[0].level == 0.0f
+        && s.drones.active == 0
+        && !p.voc.enabled.load(std::memory_order_relaxed) && !p.harm.enabled.load(std::memory_order_relaxed)
+        && !p.tape.enabled.load(std::memory_order_relaxed) && !s.tape.active
+        && !p.dyn.enabled.load(std::memory_order_relaxed) && !s.dyn.active
+        && !eq_change_pending(s.eq, p.eq);
+}
+
+// Fused output for the common chain: the gained voice goes through the
+// harmonizer history, the crossfeed delay, the EQ at its settled
+// coefficients (when it is not at identity) and into interleaved stereo in
+// one pass, four frames per SSE vector, with nothing staged in between.
+// Runs split wherever a ring buffer wraps.
+template <bool Eq>
+static inline void engine_fused_output(Engine& e, float* out, uint32_t frames) {
+    SynthState& s = e.synth;
+    const float* voice = s.voice;
+    float* hist = s.harm.history.data();
+    float* bufL = s.crossL.buf.data();
+    float* bufR = s.crossR.buf.data();
+    const uint32_t hmask = s.harm.mask;
+    const uint32_t dmask = s.crossL.mask;  // both sides have the same length
+    const __m128 wet = _mm_set1_ps(0.15f), dry = _mm_set1_ps(0.85f);
+
+    for (uint32_t i = 0; i < frames; ) {
+        const uint32_t h = uint32_t(s.frameIndex + i) & hmask;
+        const uint32_t r = (s.crossL.pos + i - s.crossDelay) & dmask;
+        const uint32_t w = (s.crossL.pos + i) & dmask;
+        const uint32_t run = std::min(std::min(frames - i, hmask + 1 - h), std::min(dmask + 1 - r, dmask + 1 - w));
+        const float* x = voice + i;
+        float* o = out + size_t(i) * 2;
+        uint32_t j = 0;
+        for (; j + 4 <= run; j += 4) {
+            const __m128 v = _mm_loadu_ps(x + j);
+            const __m128 dL = _mm_loadu_ps(bufL + r + j);
+            const __m128 dR = _mm_loadu_ps(bufR + r + j);
+            _mm_storeu_ps(hist + h + j, v);
+            _mm_storeu_ps(bufL + w + j, _mm_add_ps(_mm_mul_ps(dry, dL), _mm_mul_ps(wet, v)));
+            _mm_storeu_ps(bufR + w + j, _mm_add_ps(_mm_mul_ps(dry, dR), _mm_mul_ps(wet, v)));
+            const __m128 L = _mm_add_ps(_mm_mul_ps(dry, v), _mm_mul_ps(wet, dR));
+            const __m128 R = _mm_add_ps(_mm_mul_ps(dry, v), _mm_mul_ps(wet, dL));
+            __m128 lo = _mm_unpacklo_ps(L, R), hi = _mm_unpackhi_ps(L, R);
+            if (Eq) { lo = eq_stereo_pair(s.eq, lo); hi = eq_stereo_pair(s.eq, hi); }
+            _mm_storeu_ps(o + 2 * j, lo);
+            _mm_storeu_ps(o + 2 * j + 4, hi);
+        }
+        for (; j < run; ++j) {
+            const float v = x[j], dL = bufL[r + j], dR = bufR[r + j];
+            hist[h + j] = v;
+            bufL[w + j] = 0.85f * dL + 0.15f * v;
+            bufR[w + j] = 0.85f * dR + 0.15f * v;
+            float L = 0.85f * v + 0.15f * dR, R = 0.85f * v + 0.15f * dL;
+            if (Eq) {
+                alignas(16) float y[4];
+                _mm_store_ps(y, eq_frame(s.eq, _mm_setr_ps(L, R, 0.0f, 0.0f)));
+                L = y[0]; R = y[1];
+            }
+            o[2 * j + 0] = L;
+            o[2 * j + 1] = R;
+        }
+        i += run;
+    }
+    s.crossL.pos += frames;
+    s.crossR.pos += frames;
+}
+
+// Render up to kBlockFrames interleaved float frames into `out`
+static inline void engine_render(Engine& e, float* out, uint32_t frames, int channels, float sampleRate) {
+    SynthState& s = e.synth;
+    SynthParams& p = e.params;
+    const EngineConfig* cfg = e.config.load();
+    const EngineConfig& c = cfg ? *cfg : kEngineDefaults;
+
+    // Smooth coefficients: fixed, or from the cutoffs engine_drain derives
+    // from gesture speed (expf only reruns when an event changed them)
+    float hzSmoothCoeff = c.hzSmooth;
+    float gainSmoothCoeff = c.gainSmooth;
+    if (p.adaptiveSmoothing.load()) {
+        hzSmoothCoeff = s.hzSlew.get(p.hzCutoff.load(), sampleRate);
+        gainSmoothCoeff = s.gainSlew.get(p.gainCutoff.load(), sampleRate);
+    }
+
+    // Predicted targets: extrapolate the gesture to when this block is heard
+    bool  predicted = false;
+    float predHz = 0.0f, predGain = 0.0f;
+    if (p.predictGesture.load() && s.playTime > 0.0) {
+        const GestureSample g = gesture_read(p.gesture);
+        if (g.t > 0.0) {
+            predHz = map_nx_to_hz(c, predict_position(g.x, g.vx, g.cx, g.t, s.renderTime, s.playTime));
+            predGain = map_ny_to_gain(c, predict_position(g.y, g.vy, g.cy, g.t, s.renderTime, s.playTime));
+            predicted = true;
+        }
+    }
+
+    // Stem recording: one record per block, filled in place as stages finish
+    SpscRing* rec = e.stemTap;
+    const bool stems = rec && spsc_reserve(*rec, kRecordHeader + kStemChannels * frames);
+    if (stems) {
+        spsc_at(*rec, 0) = e.stemTake;
+        spsc_at(*rec, 1) = float(kStemChannels * frames);
+    }
+
+    // Gain is handled per block by the gain stage below
+    const float tgtGain = predicted ? predGain : p.targetGain.load();
+    const bool  mute = p.mute.load();
+    const int   mode = p.mode.load();
+
+    // Control rate: slew and vibrato advance a whole period at a time
+    const uint32_t ctlFrames = uint32_t(std::max(1, std::min(int(kMaxControlFrames), p.controlFrames.load())));
+    const float  hzSmoothK = krate_coeff(hzSmoothCoeff, ctlFrames);
+
+    // Chord/arpeggio: the main voice plays the scale-quantised root
+    const ChordMode chordMode = ChordMode(p.chord.mode.load());
+    float tgtHz = predicted ? predHz : p.targetHz.load();
+    if (chordMode != ChordMode::Off) tgtHz = chord_root(s.chord, tgtHz, p.chord.tonicHz.load());
+    const float hzStart = s.pitch.value;
+
+    float* bus = s.bus;
+
+    // Fast path: the gain rides in the voice loop and one pass does the rest
+    const bool fused = engine_can_fuse(e, chordMode, channels);
+    float g0 = 1.0f, g1 = 1.0f;
+    if (fused) {
+        g0 = s.gain.last;
+        g1 = gain_advance(s.gain, p.gain, frames, tgtGain, gainSmoothCoeff, mute, mode, sampleRate);
+        s.gain.last = g1;
+    }
+
+    // The voice: one fused loop per mode
+    switch (mode) {
+    case 2:  engine_voice(e, s.chains.mode2, tgtHz, hzSmoothK, ctlFrames, g0, g1, frames, sampleRate); break;
+    case 3:  engine_voice(e, s.chains.mode3, tgtHz, hzSmoothK, ctlFrames, g0, g1, frames, sampleRate); break;
+    case 4:  engine_voice(e, s.chains.mode4, tgtHz, hzSmoothK, ctlFrames, g0, g1, frames, sampleRate); break;
+    default: engine_voice(e, s.chains.mode1, tgtHz, hzSmoothK, ctlFrames, g0, g1, frames, sampleRate); break;
+    }
+
+    if (fused) {
+        if (s.eq.identity) engine_fused_output<false>(e, out, frames);
+        else engine_fused_output<true>(e, out, frames);
+        ++s.fusedBlocks;
+        if (e.analysisTap) spsc_write(*e.analysisTap, out, frames * 2);
+        s.frameIndex += frames;
+        return;
+    }
+
+    if (chordMode != ChordMode::Off || s.chord.arp.level > 0.0f || s.chord.tone[0].level > 0.0f)
+        engine_pool_voices(e, chordMode, mode, hzStart, s.pitch.value, frames, sampleRate);
+
+    // Amplitude, mute, master and mode trim as one ramp over the block
+    gain_process(s.gain, p.gain, s.voice, frames, tgtGain, gainSmoothCoeff, mute, mode, sampleRate);
+
+    // Drones keep their frozen levels but share mute, master and mode trim
+    if (s.drones.active) {
+        std::fill(s.droneBuf, s.droneBuf + frames, 0.0f);
+        drone_render(s.drones, s.droneBuf, frames, sampleRate);
+        const float g = s.gain.mute * fast_db_to_gain(s.gain.trimDb);
+        gain_ramp_apply(s.droneBuf, frames, s.droneGain, g);
+        s.droneGain = g;
+        for (uint32_t i = 0; i < frames; ++i) s.voice[i] += s.droneBuf[i];
+    }
+    for (uint32_t i = 0; i < frames; ++i) s.dryL[i] = s.dryR[i] = s.voice[i];
+
+    if (p.voc.enabled.load()) {
+        modulator_pull(s.mod, s.modBlock, frames);
+        vocoder_process(s.voc, p.voc, s.voice, s.modBlock, frames, sampleRate);
+        for (uint32_t i = 0; i < frames; ++i) s.dryL[i] = s.dryR[i] = s.voice[i];
+    }
+
+    // Harmony voices are shifted copies of this block's voice
+    harmonizer_process(s.harm, p.harm, s.voice, s.dryL, s.dryR,
+        frames, s.frameIndex, s.smoothHz, sampleRate);
+
+    if (stems) {
+        spsc_put(*rec, StemOffset(kStemVoice, frames), s.voice, frames);
+        for (int v = 0; v < kHarmVoices; ++v) {
+            const float g = s.harm.voiceGain[v];
+            const uint32_t at = StemOffset(kStemHarm1 + v, frames);
+            for (uint32_t i = 0; i < frames; ++i) spsc_at(*rec, at + i) = g * s.harm.scratch[v][i];
+        }
+        spsc_put(*rec, StemOffset(kStemDryL, frames), s.dryL, frames);
+        spsc_put(*rec, StemOffset(kStemDryR, frames), s.dryR, frames);
+    }
+
+    // Minimal stereo decorrelation via short delay & crossfeed. It runs
+    // under the tape delay too, so its rings are never stale.
+    {
+        float* tapL = s.tapL;
+        float* tapR = s.tapR;
+        delay_read_block(s.crossL, s.crossDelay, tapL, frames);
+        delay_read_block(s.crossR, s.crossDelay, tapR, frames);
+        for (uint32_t i = 0; i < frames; ++i) {
+            float dryL = s.dryL[i];
+            float dryR = s.dryR[i];
+            float dL = tapL[i];
+            float dR = tapR[i];
+            tapL[i] = 0.85f * dL + 0.15f * dryL;
+            tapR[i] = 0.85f * dR + 0.15f * dryR;
+
+            bus[i * 4 + 0] = 0.85f * dryL + 0.15f * dR;
+            bus[i * 4 + 1] = 0.85f * dryR + 0.15f * dL;
+            bus[i * 4 + 2] = 0.0f;
+            bus[i * 4 + 3] = 0.0f;
+        }
+        delay_write_block(s.crossL, tapL, frames);
+        delay_write_block(s.crossR, tapR, frames);
+    }
+
+    // Tape echoes on top, until they have rung out after switching off
+    if (tape_delay_process(s.tape, p.tape, s.dryL, s.dryR, s.tapL, s.tapR, frames, sampleRate)) {
+        for (uint32_t i = 0; i < frames; ++i) {
+            bus[i * 4 + 0] += s.tapL[i];
+            bus[i * 4 + 1] += s.tapR[i];
+        }
+    }
+
+    // Effect return: whatever the delay/crossfeed added to the dry bus
+    if (stems) {
+        const uint32_t atL = StemOffset(kStemFxL, frames), atR = StemOffset(kStemFxR, frames);
+        for (uint32_t i = 0; i < frames; ++i) {
+            spsc_at(*rec, atL + i) = bus[i * 4 + 0] - s.dryL[i];
+            spsc_at(*rec, atR + i) = bus[i * 4 + 1] - s.dryR[i];
+        }
+    }
+
+    // Output chain (block-wise, SIMD across lanes)
+    eq_process(s.eq, p.eq, bus, frames, sampleRate);
+    dynamics_process(s.dyn, p.dyn, bus, frames, sampleRate);
+
+    if (stems) {
+        const uint32_t atL = StemOffset(kStemMixL, frames), atR = StemOffset(kStemMixR, frames);
+        for (uint32_t i = 0; i < frames; ++i) {
+            spsc_at(*rec, atL + i) = bus[i * 4 + 0];
+            spsc_at(*rec, atR + i) = bus[i * 4 + 1];
+        }
+        spsc_commit(*rec, kRecordHeader + kStemChannels * frames);
+    }
+
+    // Analysis tap (dropped, never waited on, if the meter falls behind)
+    if (e.analysisTap) {
+        for (uint32_t i = 0; i < frames; ++i) {
+            s.stereo[i * 2 + 0] = bus[i * 4 + 0];
+            s.stereo[i * 2 + 1] = bus[i * 4 + 1];
+        }
+        spsc_write(*e.analysisTap, s.stereo, frames * 2);
+    }
+
+    // Write interleaved float
+    for (uint32_t i = 0; i < frames; ++i) {
+        out[i * channels + 0] = bus[i * 4 + 0];
+        if (channels > 1) out[i * channels + 1] = bus[i * 4 + 1];
+    }
+
+    s.frameIndex += frames;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// ------------------------------
+// Epoch-based reclamation for objects the render thread reads
+// ------------------------------
+//
+// A writer swaps in a new object with an atomic exchange and retires the old
+// one instead of freeing it. Each reader publishes the global epoch once per
+// block (one load and one store, wait-free) before it loads any shared
+// pointer. A retired object is freed once every active reader has published
+// a later epoch, since such a reader can only have loaded the new pointer.
+//
+// Readers never free anything and never take the lock; retiring and
+// collecting run on the UI and worker threads. Shared pointers must be
+// loaded with the default (sequentially consistent) ordering after
+// epoch_enter, so the load cannot be seen before the published epoch.
+
+static constexpr int kEpochReaders = 4;
+static constexpr int kEpochRender = 0; // the engine's render thread
+
+struct EpochDomain {
+    struct alignas(64) Reader {
+        std::atomic<uint64_t> epoch{ 0 };  // 0 = not reading
+    };
+    struct Retired {
+        void*    p;
+        void   (*free)(void*);
+        uint64_t epoch;                    // readers at or below it may hold p
+    };
+    std::atomic<uint64_t> global{ 1 };
+    Reader                reader[kEpochReaders];
+    std::mutex            lock;            // retired list, writers only
+    std::vector<Retired>  retired;
+
+    EpochDomain() = default;
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+    ~EpochDomain() { // no readers are left by now
+        for (const Retired& r : retired) r.free(r.p);
+    }
+};
+
+// Reader, once per block before loading shared pointers
+static inline void epoch_enter(EpochDomain& d, int reader) {
+    d.reader[reader].epoch.store(d.global.load(std::memory_order_acquire));
+}
+
+// Reader, when it stops rendering (otherwise its last epoch holds everything
+// retired since)
+static inline void epoch_leave(EpochDomain& d, int reader) {
+    d.reader[reader].epoch.store(0);
+}
+
+// Any thread but a reader: hand over an object already unlinked from every
+// shared pointer. It is freed by a later epoch_collect.
+template <class T>
+static inline void epoch_retire(EpochDomain& d, T* p) {
+    if (!p) return;
+    std::lock_guard<std::mutex> l(d.lock);
+    d.retired.push_back({ p, [](void* q) { delete static_cast<T*>(q); }, d.global.fetch_add(1) });
+}
+
+// Any thread but a reader: free what no reader can still hold. Returns the
+// number of objects freed.
+static inline size_t epoch_collect(EpochDomain& d) {
+    std::vector<EpochDomain::Retired> done;
+    {
+        // Readers are scanned under the lock, after every listed object was
+        // unlinked: one that entered since can only have seen the new pointer
+        std::lock_guard<std::mutex> l(d.lock);
+        if (d.retired.empty()) return 0;
+        uint64_t oldest = UINT64_MAX;
+        for (int i = 0; i < kEpochReaders; ++i) {
+            const uint64_t e = d.reader[i].epoch.load();
+            if (e != 0 && e < oldest) oldest = e;
+        }
+        size_t keep = 0;
+        for (const EpochDomain::Retired& r : d.retired) {
+            if (r.epoch < oldest) done.push_back(r);
+            else d.retired[keep++] = r;
+        }
+        d.retired.resize(keep);
+    }
+    for (const EpochDomain::Retired& r : done) r.free(r.p);
+    return done.size();
+}
+
+// Any thread: objects waiting for readers to move on
+static inline size_t epoch_pending(EpochDomain& d) {
+    std::lock_guard<std::mutex> l(d.lock);
+    return d.retired.size();
+}
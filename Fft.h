@@ -0,0 +1,63 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// ------------------------------
+// Radix-2 complex FFT (split real/imag arrays)
+// ------------------------------
+//
+// Tables are built once in init(); run() does no allocation and is safe on
+// the audio thread.
+
+struct Fft {
+    int n = 0;
+    std::vector<float>    cosT, sinT; // twiddles, n/2 entries
+    std::vector<uint32_t> rev;        // bit-reversal permutation
+
+    void init(int size) {
+        n = size;
+        int bits = 0;
+        while ((1 << bits) < n) ++bits;
+        cosT.resize(n / 2);
+        sinT.resize(n / 2);
+        for (int k = 0; k < n / 2; ++k) {
+            const double w = -6.283185307179586 * k / n;
+            cosT[k] = float(cos(w));
+            sinT[k] = float(sin(w));
+        }
+        rev.resize(n);
+        for (int i = 0; i < n; ++i) {
+            uint32_t r = 0;
+            for (int b = 0; b < bits; ++b) r |= ((uint32_t(i) >> b) & 1u) << (bits - 1 - b);
+            rev[i] = r;
+        }
+    }
+
+    // In place; the inverse is unscaled (divide by n yourself)
+    void run(float* re, float* im, bool inverse) const {
+        for (int i = 0; i < n; ++i) {
+            const int j = int(rev[i]);
+            if (j > i) {
+                float t = re[i]; re[i] = re[j]; re[j] = t;
+                t = im[i]; im[i] = im[j]; im[j] = t;
+            }
+        }
+        const float sgn = inverse ? -1.0f : 1.0f;
+        for (int len = 2; len <= n; len <<= 1) {
+            const int half = len >> 1;
+            const int step = n / len;
+            for (int i = 0; i < n; i += len) {
+                for (int k = 0; k < half; ++k) {
+                    const float wr = cosT[k * step];
+                    const float wi = sgn * sinT[k * step];
+                    const int a = i + k, b = a + half;
+                    const float xr = re[b] * wr - im[b] * wi;
+                    const float xi = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - xr; im[b] = im[a] - xi;
+                    re[a] += xr;        im[a] += xi;
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <emmintrin.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "SimdMath.h"
+
+// ------------------------------
+// Voice gain stage: dB-domain smoothing, ramped mute, master and mode trim
+// ------------------------------
+//
+// The gesture gain is smoothed in dB once per block, so fades move evenly
+// in loudness rather than crawling through the quiet end. Within a block
+// the gain follows a geometric ramp (a straight line in dB), or a linear
+// one when either end is silent, applied four samples at a time.
+
+static constexpr float kGainFloorDb = -80.0f;   // treated as silence
+static constexpr float kGainSilent = 1e-4f;     // linear equivalent of the floor
+static constexpr float kMasterMinDb = -40.0f;
+static constexpr float kMasterMaxDb = 12.0f;
+
+// Auto-gain per mode (index = mode), measured RMS referred to modes 2/3
+static constexpr float kModeTrimDb[5] = { 0.0f, -2.4f, 0.0f, 0.3f, 5.0f };
+
+struct GainParams {
+    std::atomic<float> masterDb{ 0.0f };
+    std::atomic<bool>  autoGain{ true };    // level-match modes 1..4
+    std::atomic<float> muteRampMs{ 5.0f };
+};
+
+struct GainState {
+    float db = kGainFloorDb;  // smoothed gesture gain
+    float mute = 1.0f;        // 1 = open, 0 = muted; ramps linearly
+    float trimDb = 0.0f;      // smoothed master + mode trim
+    float last = 0.0f;        // total gain at the end of the previous block
+};
+
+static inline void gain_reset(GainState& s) {
+    s.db = kGainFloorDb;
+    s.mute = 1.0f;
+    s.trimDb = 0.0f;
+    s.last = 0.0f;
+}
+
+// x[i] *= ramp from g0 (exclusive) to g1 (reached at the last sample)
+static inline void gain_ramp_apply(float* x, uint32_t n, float g0, float g1) {
+    if (n == 0) return;
+    if (g0 == g1) {
+        const __m128 g = _mm_set1_ps(g1);
+        uint32_t i = 0;
+        for (; i + 4 <= n; i += 4) _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), g));
+        for (; i < n; ++i) x[i] *= g1;
+        return;
+    }
+    const bool geometric = g0 >= kGainSilent && g1 >= kGainSilent;
+    // Per-sample step: a ratio (geometric) or an increment (linear)
+    const float step = geometric ? fast_exp2f(fast_log2f(g1 / g0) / float(n)) : (g1 - g0) / float(n);
+    float lane[4];
+    if (geometric) {
+        lane[0] = g0 * step; lane[1] = lane[0] * step; lane[2] = lane[1] * step; lane[3] = lane[2] * step;
+    } else {
+        lane[0] = g0 + step; lane[1] = g0 + 2.0f * step; lane[2] = g0 + 3.0f * step; lane[3] = g0 + 4.0f * step;
+    }
+    __m128 g = _mm_loadu_ps(lane);
+    uint32_t i = 0;
+    if (geometric) {
+        const __m128 r4 = _mm_set1_ps(step * step * step * step);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), g));
+            g = _mm_mul_ps(g, r4);
+        }
+    } else {
+        const __m128 d4 = _mm_set1_ps(4.0f * step);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), g));
+            g = _mm_add_ps(g, d4);
+        }
+    }
+    // Tail, then land exactly on g1 (no drift across blocks)
+    float gi = _mm_cvtss_f32(g);
+    for (; i < n; ++i) {
+        x[i] *= (i + 1 == n) ? g1 : gi;
+        gi = geometric ? gi * step : gi + step;
+    }
+}
+
+// Same ramp one sample at a time, for loops that apply the gain inline.
+// The caller uses `g1` itself on the last sample.
+struct GainRamp {
+    float g = 0.0f, step = 0.0f, g1 = 0.0f;
+    bool  geometric = false;
+};
+
+static inline GainRamp gain_ramp_begin(float g0, float g1, uint32_t n) {
+    GainRamp r;
+    r.g = g0;
+    r.g1 = g1;
+    if (g0 == g1 || n == 0) return r;
+    r.geometric = g0 >= kGainSilent && g1 >= kGainSilent;
+    r.step = r.geometric ? fast_exp2f(fast_log2f(g1 / g0) / float(n)) : (g1 - g0) / float(n);
+    return r;
+}
+
+static inline float gain_ramp_next(GainRamp& r) {
+    r.g = r.geometric ? r.g * r.step : r.g + r.step;
+    return r.g;
+}
+
+// Advance the block's smoothing and return the gain to reach by its last
+// sample (the ramp starts from s.last). `target` is the 0..1 gesture gain
+// and `coeff` the per-sample slew coefficient it would have used.
+static inline float gain_advance(GainState& s, const GainParams& p, uint32_t frames,
+                                 float target, float coeff, bool mute, int mode, float sampleRate) {
+    // One-pole advanced by a whole block: 1 - (1 - c)^n
+    const float blockCoeff = 1.0f - powf(1.0f - coeff, float(frames));
+    const float targetDb = target > kGainSilent ? fast_gain_to_db(target) : kGainFloorDb;
+    s.db += blockCoeff * (targetDb - s.db);
+
+    // Master/trim changes are slewed too (keys step them by whole dB)
+    float trimDb = std::fmin(kMasterMaxDb, std::fmax(kMasterMinDb, p.masterDb.load(std::memory_order_relaxed)));
+    if (p.autoGain.load(std::memory_order_relaxed) && mode >= 1 && mode <= 4) trimDb += kModeTrimDb[mode];
+    s.trimDb += (1.0f - expf(-float(frames) / (0.01f * sampleRate))) * (trimDb - s.trimDb);
+
+    const float rampFrames = std::fmax(1.0f, p.muteRampMs.load(std::memory_order_relaxed) * 0.001f * sampleRate);
+    const float muteStep = float(frames) / rampFrames;
+    s.mute = mute ? std::fmax(0.0f, s.mute - muteStep) : std::fmin(1.0f, s.mute + muteStep);
+
+    float g = 0.0f;
+    if (s.db > kGainFloorDb + 0.5f && s.mute > 0.0f) g = s.mute * fast_db_to_gain(s.db + s.trimDb);
+    return g;
+}
+
+// Apply the block's gain to `voice`
+static inline void gain_process(GainState& s, const GainParams& p, float* voice, uint32_t frames,
+                                float target, float coeff, bool mute, int mode, float sampleRate) {
+    const float g = gain_advance(s, p, frames, target, coeff, mute, mode, sampleRate);
+    gain_ramp_apply(voice, frames, s.last, g);
+    s.last = g;
+}
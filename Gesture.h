@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+// ------------------------------
+// Gesture conditioning (runs on control events, not per sample)
+// ------------------------------
+
+// One-Euro style adaptive cutoff: the slower the gesture, the lower the
+// cutoff (steady tone when holding), the faster, the higher (no glide lag).
+// Positions are normalised 0..1 so speeds are in "window widths per second".
+struct AdaptiveSmoother {
+    float  minCutoff = 3.0f;   // Hz when still
+    float  beta = 60.0f;       // Hz added per unit/s of speed
+    float  maxCutoff = 400.0f; // ~ the old fixed slew
+    float  dCutoff = 1.0f;     // speed estimate smoothing
+    float  prevX = 0.0f;
+    float  speed = 0.0f;       // filtered |dx/dt|
+    double prevT = 0.0;
+    bool   primed = false;
+};
+
+static inline float one_euro_alpha(float cutoffHz, float dt) {
+    const float tau = 1.0f / (6.28318530717958647692f * cutoffHz);
+    return 1.0f / (1.0f + tau / dt);
+}
+
+// Feed one control event; returns the cutoff (Hz) the audio-rate slew should use
+static inline float adaptive_cutoff(AdaptiveSmoother& s, float x, double t) {
+    if (!s.primed) {
+        s.prevX = x;
+        s.prevT = t;
+        s.primed = true;
+        return s.minCutoff;
+    }
+    const float dt = float(std::fmax(t - s.prevT, 1e-4));
+    const float v = fabsf(x - s.prevX) / dt;
+    s.speed += one_euro_alpha(s.dCutoff, dt) * (v - s.speed);
+    s.prevX = x;
+    s.prevT = t;
+    return std::fmin(s.maxCutoff, s.minCutoff + s.beta * s.speed);
+}
+
+// Caches the per-sample one-pole coefficient for a cutoff set by
+// engine_drain, so expf only runs when a new event changed it.
+struct CutoffCoeff {
+    float hz = -1.0f;
+    float coeff = 0.0f;
+
+    float get(float cutoffHz, float sampleRate) {
+        if (cutoffHz != hz) {
+            hz = cutoffHz;
+            coeff = 1.0f - expf(-6.28318530717958647692f * cutoffHz / sampleRate);
+        }
+        return coeff;
+    }
+};
+
+// Constant-velocity predictor (alpha-beta filter, i.e. a steady-state
+// Kalman filter) on one normalised axis, updated per control event.
+struct GesturePredictor {
+    float  alpha = 0.85f;  // position correction gain (1 = trust samples fully)
+    float  beta = 0.5f;    // velocity correction gain
+    float  x = 0.0f;       // filtered position
+    float  v = 0.0f;       // velocity, units/s
+    float  err2 = 0.0f;    // smoothed squared innovation
+    double t = 0.0;
+    bool   primed = false;
+};
+
+static inline void predictor_update(GesturePredictor& p, float z, double t) {
+    if (!p.primed) {
+        p.x = z; p.v = 0.0f; p.err2 = 0.0f; p.t = t; p.primed = true;
+        return;
+    }
+    const float dt = float(std::fmax(t - p.t, 1e-4));
+    if (dt > 0.1f) p.v = 0.0f;            // after a pause, restart from rest
+    const float xp = p.x + p.v * dt;
+    const float r = z - xp;               // innovation: how wrong the last prediction was
+    p.x = xp + p.alpha * r;
+    p.v += (p.beta / dt) * r;
+    p.err2 += 0.3f * (r * r - p.err2);
+    p.t = t;
+}
+
+// 1 when recent predictions were accurate, falling to 0 as the innovation
+// approaches `tolerance` (normalised units)
+static inline float predictor_confidence(const GesturePredictor& p, float tolerance) {
+    const float e = sqrtf(p.err2) / tolerance;
+    return std::fmax(0.0f, 1.0f - e);
+}
+
+// Extrapolate a position published at `tEvent` to `tPlay`, when the audio
+// being rendered at `tNow` reaches the speaker. The horizon is capped, and
+// the prediction fades back to the measured value when confidence is low or
+// events stop arriving (the window only gets moves while the hand moves).
+static inline float predict_position(float x, float v, float confidence,
+                                     double tEvent, double tNow, double tPlay,
+                                     float maxHorizon = 0.05f, float grace = 0.02f, float fade = 0.03f) {
+    const float horizon = std::fmin(float(tPlay - tEvent), maxHorizon);
+    if (horizon <= 0.0f) return x;
+    const float idle = std::fmax(0.0f, float(tNow - tEvent) - grace);
+    const float fresh = std::fmax(0.0f, 1.0f - idle / fade);
+    const float p = x + confidence * fresh * v * horizon;
+    return std::fmin(1.0f, std::fmax(0.0f, p));
+}
+
+// Predictor output for both axes, published per event by engine_drain and
+// read once per block, both on the render thread. Seqlock: an odd sequence
+// means a write is in progress; the reader retries if the sequence moved.
+struct GestureSample {
+    double t = 0.0;                    // event time (NowSeconds), 0 = none yet
+    float  x = 0.5f, vx = 0.0f, cx = 0.0f;
+    float  y = 1.0f, vy = 0.0f, cy = 0.0f;
+};
+
+struct GestureSnapshot {
+    std::atomic<uint32_t> seq{ 0 };
+    std::atomic<double>   t{ 0.0 };
+    std::atomic<float>    x{ 0.5f }, vx{ 0.0f }, cx{ 0.0f };
+    std::atomic<float>    y{ 1.0f }, vy{ 0.0f }, cy{ 0.0f };
+};
+
+static inline void gesture_publish(GestureSnapshot& s, const GestureSample& g) {
+    const uint32_t q = s.seq.load(std::memory_order_relaxed);
+    s.seq.store(q + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.t.store(g.t, std::memory_order_relaxed);
+    s.x.store(g.x, std::memory_order_relaxed);
+    s.vx.store(g.vx, std::memory_order_relaxed);
+    s.cx.store(g.cx, std::memory_order_relaxed);
+    s.y.store(g.y, std::memory_order_relaxed);
+    s.vy.store(g.vy, std::memory_order_relaxed);
+    s.cy.store(g.cy, std::memory_order_relaxed);
+    s.seq.store(q + 2, std::memory_order_release);
+}
+
+static inline GestureSample gesture_read(const GestureSnapshot& s) {
+    GestureSample g;
+    for (;;) {
+        const uint32_t q = s.seq.load(std::memory_order_acquire);
+        if (q & 1u) continue;
+        g.t = s.t.load(std::memory_order_relaxed);
+        g.x = s.x.load(std::memory_order_relaxed);
+        g.vx = s.vx.load(std::memory_order_relaxed);
+        g.cx = s.cx.load(std::memory_order_relaxed);
+        g.y = s.y.load(std::memory_order_relaxed);
+        g.vy = s.vy.load(std::memory_order_relaxed);
+        g.cy = s.cy.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.seq.load(std::memory_order_relaxed) == q) return g;
+    }
+}
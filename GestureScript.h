@@ -0,0 +1,114 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// ------------------------------
+// Gesture scripts for offline rendering
+// ------------------------------
+//
+// One event per line: a time in seconds, a verb, then arguments. Blank
+// lines and '#' comments are skipped; events are applied in time order.
+//
+//   0.0  mode 4            1..4
+//   0.0  pos 0.25 0.2      x (pitch) and y (0 = loud) over the play area
+//   1.0  gain 0.8          volume 0..1, keeps the pitch
+//   1.5  vibrato 1         depth 0..1
+//   2.0  latch             freeze the voice into a drone
+//   4.0  release [all]     fade the newest drone, or all of them
+//   2.0  chord arp         off | chord | arp
+//   3.0  fx delay on       eq | comp | harmony | vocoder | delay, on | off
+//   3.0  master -6         dB
+//   8.0  end               length of the render
+
+enum class ScriptOp : uint8_t { Pos, Gain, Vibrato, Latch, Release, ReleaseAll, Mode, Chord, Fx, Master, End };
+enum class ScriptFx : uint8_t { Eq, Comp, Harmony, Vocoder, Delay };
+
+struct ScriptEvent {
+    double   t = 0.0;
+    ScriptOp op = ScriptOp::Pos;
+    float    a = 0.0f, b = 0.0f;
+};
+
+static inline bool script_number(const std::string& s, double& v) {
+    char* end = nullptr;
+    v = strtod(s.c_str(), &end);
+    return !s.empty() && *end == '\0';
+}
+
+// Returns false (and the 1-based line) on the first line it cannot read
+static inline bool script_parse(const char* text, size_t size, std::vector<ScriptEvent>& out, int* errorLine) {
+    static const char* const kChordNames[] = { "off", "chord", "arp" };
+    static const char* const kFxNames[] = { "eq", "comp", "harmony", "vocoder", "delay" };
+    out.clear();
+    const std::string src(text, size);
+    size_t pos = 0;
+    for (int line = 1; pos < src.size(); ++line) {
+        size_t end = src.find('\n', pos);
+        if (end == std::string::npos) end = src.size();
+        std::string l = src.substr(pos, end - pos);
+        pos = end + 1;
+        const size_t hash = l.find('#');
+        if (hash != std::string::npos) l.resize(hash);
+
+        // Whitespace-separated words: time, verb, up to two arguments
+        std::vector<std::string> w;
+        for (size_t i = 0; i < l.size(); ) {
+            while (i < l.size() && isspace(uint8_t(l[i]))) ++i;
+            size_t j = i;
+            while (j < l.size() && !isspace(uint8_t(l[j]))) ++j;
+            if (j > i) w.push_back(l.substr(i, j - i));
+            i = j;
+        }
+        if (w.empty()) continue;
+
+        ScriptEvent e;
+        double a = 0.0, b = 0.0;
+        bool ok = w.size() >= 2 && w.size() <= 4 && script_number(w[0], e.t) && e.t >= 0.0;
+        const std::string verb = ok ? w[1] : std::string();
+        const size_t args = w.size() - 2;
+        if (!ok) {
+        } else if (verb == "pos") {
+            e.op = ScriptOp::Pos;
+            ok = args == 2 && script_number(w[2], a) && script_number(w[3], b);
+        } else if (verb == "gain" || verb == "vibrato" || verb == "mode" || verb == "master") {
+            e.op = verb == "gain" ? ScriptOp::Gain : verb == "vibrato" ? ScriptOp::Vibrato
+                 : verb == "mode" ? ScriptOp::Mode : ScriptOp::Master;
+            ok = args == 1 && script_number(w[2], a);
+        } else if (verb == "latch" || verb == "end") {
+            e.op = verb == "latch" ? ScriptOp::Latch : ScriptOp::End;
+            ok = args == 0;
+        } else if (verb == "release") {
+            e.op = args == 1 && w[2] == "all" ? ScriptOp::ReleaseAll : ScriptOp::Release;
+            ok = args == 0 || e.op == ScriptOp::ReleaseAll;
+        } else if (verb == "chord") {
+            e.op = ScriptOp::Chord;
+            ok = false;
+            for (int i = 0; i < 3 && args == 1; ++i)
+                if (w[2] == kChordNames[i]) { a = i; ok = true; }
+        } else if (verb == "fx") {
+            e.op = ScriptOp::Fx;
+            ok = false;
+            for (int i = 0; i < 5 && args == 2 && (w[3] == "on" || w[3] == "off"); ++i)
+                if (w[2] == kFxNames[i]) { a = i; b = w[3] == "on" ? 1.0 : 0.0; ok = true; }
+        } else {
+            ok = false;
+        }
+        if (!ok) { if (errorLine) *errorLine = line; return false; }
+        e.a = float(a);
+        e.b = float(b);
+        out.push_back(e);
+    }
+    std::stable_sort(out.begin(), out.end(), [](const ScriptEvent& x, const ScriptEvent& y) { return x.t < y.t; });
+    return true;
+}
+
+// Render length: the `end` event, else two seconds past the last event
+static inline double script_length(const std::vector<ScriptEvent>& ev) {
+    for (const ScriptEvent& e : ev)
+        if (e.op == ScriptOp::End) return e.t;
+    return ev.empty() ? 0.0 : ev.back().t + 2.0;
+}
@@ -0,0 +1,265 @@
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Fft.h"
+
+// ------------------------------
+// Harmonizer: pitch-shifted copies of the voice
+// ------------------------------
+//
+// Default path is TD-PSOLA. The engine knows its own fundamental, so the
+// analysis marks are simply the main oscillator's phase wraps and the
+// grains are two periods long: no pitch detection, ~2 periods of latency.
+// The high-quality path is a phase vocoder (1024-point, 4x overlap) which
+// also copes with the noisy modes, at ~20 ms latency and more CPU.
+
+static constexpr int      kHarmVoices = 2;
+static constexpr float    kHarmMinHz = 20.0f;   // lowest fundamental the grains are sized for
+static constexpr uint32_t kHarmMaxBlock = 512;  // frames written to history per call
+static constexpr int      kHarmMarks = 16;      // recent pitch marks kept
+static constexpr int      kHarmGrains = 8;      // live grains per voice
+static constexpr int      kHannTable = 1024;
+static constexpr int      kPvSize = 1024;       // phase vocoder frame
+static constexpr int      kPvOversample = 4;
+
+struct HarmonyVoiceParams {
+    std::atomic<float> semitones{ 7.0f };
+    std::atomic<float> level{ 0.5f };
+    std::atomic<float> pan{ 0.0f }; // -1 (L) .. 1 (R)
+};
+
+struct HarmonizerParams {
+    std::atomic<bool>  enabled{ false };
+    std::atomic<bool>  highQuality{ false }; // phase vocoder instead of PSOLA
+    HarmonyVoiceParams voice[kHarmVoices];
+
+    HarmonizerParams() {
+        voice[0].semitones.store(7.0f);  voice[0].pan.store(0.4f);  // fifth above
+        voice[1].semitones.store(-5.0f); voice[1].pan.store(-0.4f); // fourth below
+    }
+};
+
+struct PsolaGrain {
+    uint64_t start = 0; // absolute input index of the first sample
+    float    pos = 0.0f;
+    float    len = 0.0f;
+    bool     live = false;
+};
+
+struct PsolaVoice {
+    double     nextSynth = 0.0; // absolute output time of the next grain
+    PsolaGrain grain[kHarmGrains];
+};
+
+// Phase vocoder pitch shifter (per voice)
+struct PvVoice {
+    std::vector<float> inFifo, outFifo, accum, lastPhase, sumPhase;
+    std::vector<float> anaMag, anaFreq, synMag, synFreq, re, im;
+    int rover = 0;
+
+    void init() {
+        inFifo.assign(kPvSize, 0.0f);  outFifo.assign(kPvSize, 0.0f);
+        accum.assign(2 * kPvSize, 0.0f);
+        lastPhase.assign(kPvSize / 2 + 1, 0.0f); sumPhase.assign(kPvSize / 2 + 1, 0.0f);
+        anaMag.assign(kPvSize / 2 + 1, 0.0f); anaFreq.assign(kPvSize / 2 + 1, 0.0f);
+        synMag.assign(kPvSize / 2 + 1, 0.0f); synFreq.assign(kPvSize / 2 + 1, 0.0f);
+        re.assign(kPvSize, 0.0f); im.assign(kPvSize, 0.0f);
+        rover = kPvSize - kPvSize / kPvOversample;
+    }
+};
+
+struct HarmonizerState {
+    std::vector<float> history;           // mono input ring (power of two)
+    uint32_t   mask = 0;                  // history size - 1
+    uint64_t   marks[kHarmMarks] = {};    // absolute indices of phase wraps
+    int        markHead = 0;
+    int        markCount = 0;
+    PsolaVoice psola[kHarmVoices];
+    PvVoice    pv[kHarmVoices];
+    Fft        fft;
+    float      hann[kHannTable + 1];
+    std::vector<float> pvWindow;
+    bool       wasHighQuality = false;
+    float      scratch[kHarmVoices][kHarmMaxBlock]; // per-voice block output
+    float      voiceGain[kHarmVoices] = {}; // level of scratch[v] this block, 0 = silent
+};
+
+// A PSOLA grain starts a period before its mark, which may be a period
+// older than the newest usable one, and the mark must be a period in the
+// past: up to three periods behind the newest input, plus the block
+static inline void harmonizer_init(HarmonizerState& s, float sampleRate) {
+    const uint32_t need = uint32_t(3.0f * sampleRate / kHarmMinHz) + kHarmMaxBlock;
+    uint32_t size = 1;
+    while (size < need) size <<= 1;
+    s.history.assign(size, 0.0f);
+    s.mask = size - 1;
+    s.markHead = 0;
+    s.markCount = 0;
+    for (int i = 0; i <= kHannTable; ++i)
+        s.hann[i] = 0.5f - 0.5f * cosf(6.28318530717958647692f * i / kHannTable);
+    s.fft.init(kPvSize);
+    s.pvWindow.resize(kPvSize);
+    for (int i = 0; i < kPvSize; ++i)
+        s.pvWindow[i] = 0.5f - 0.5f * cosf(6.28318530717958647692f * i / kPvSize);
+    for (int v = 0; v < kHarmVoices; ++v) {
+        s.psola[v] = PsolaVoice{};
+        s.pv[v].init();
+    }
+}
+
+// Called by the oscillator when its phase wraps (one mark per period)
+static inline void harmonizer_mark(HarmonizerState& s, uint64_t at) {
+    s.markHead = (s.markHead + 1) % kHarmMarks;
+    s.marks[s.markHead] = at;
+    if (s.markCount < kHarmMarks) ++s.markCount;
+}
+
+static inline float harm_hann(const HarmonizerState& s, float x) { // x in [0,1]
+    const float f = x * kHannTable;
+    const int   i = int(f);
+    if (i >= kHannTable) return 0.0f;
+    return s.hann[i] + (f - i) * (s.hann[i + 1] - s.hann[i]);
+}
+
+static inline void psola_run(HarmonizerState& s, PsolaVoice& v, float ratio, float period,
+                             uint64_t t0, uint32_t frames, float* out) {
+    const float hop = period / ratio;
+    const float norm = 1.0f / ratio; // Hann grains of 2T at hop T/r sum to r
+    const uint32_t mask = s.mask;
+    if (v.nextSynth < double(t0)) v.nextSynth = double(t0);
+
+    for (uint32_t i = 0; i < frames; ++i) {
+        const uint64_t now = t0 + i;
+        while (double(now) >= v.nextSynth) {
+            v.nextSynth += hop;
+            // Newest mark whose two-period grain is already fully in history
+            // (in integers: sample indices outgrow a float's 24 bits in minutes)
+            const float len = 2.0f * period;
+            const uint64_t reach = uint64_t(ceilf(period));
+            for (int m = 0; m < s.markCount; ++m) {
+                const uint64_t c = s.marks[(s.markHead - m + kHarmMarks) % kHarmMarks];
+                if (c + reach > now || c < reach) continue;
+                for (int g = 0; g < kHarmGrains; ++g) {
+                    PsolaGrain& gr = v.grain[g];
+                    if (gr.live) continue;
+                    gr.start = c - uint64_t(period);
+                    gr.pos = 0.0f;
+                    gr.len = len;
+                    gr.live = true;
+                    break;
+                }
+                break;
+            }
+        }
+
+        float acc = 0.0f;
+        for (int g = 0; g < kHarmGrains; ++g) {
+            PsolaGrain& gr = v.grain[g];
+            if (!gr.live) continue;
+            const float x = s.history[(gr.start + uint64_t(gr.pos)) & mask];
+            acc += x * harm_hann(s, gr.pos / gr.len);
+            gr.pos += 1.0f;
+            if (gr.pos >= gr.len) gr.live = false;
+        }
+        out[i] = acc * norm;
+    }
+}
+
+// Classic STFT pitch shift: analyse true bin frequencies, move them by
+// `ratio`, resynthesise with accumulated phase.
+static inline void pv_frame(HarmonizerState& s, PvVoice& v, float ratio) {
+    const int N = kPvSize, half = N / 2, hop = N / kPvOversample;
+    const float kPi = 3.14159265358979323846f;
+    const float expct = 2.0f * kPi * hop / N;
+
+    for (int k = 0; k < N; ++k) { v.re[k] = v.inFifo[k] * s.pvWindow[k]; v.im[k] = 0.0f; }
+    s.fft.run(v.re.data(), v.im.data(), false);
+
+    for (int k = 0; k <= half; ++k) {
+        const float mag = 2.0f * sqrtf(v.re[k] * v.re[k] + v.im[k] * v.im[k]);
+        const float ph = atan2f(v.im[k], v.re[k]);
+        float d = ph - v.lastPhase[k] - k * expct;
+        v.lastPhase[k] = ph;
+        d -= 2.0f * kPi * floorf(d / (2.0f * kPi) + 0.5f);
+        v.anaMag[k] = mag;
+        v.anaFreq[k] = k + d * kPvOversample / (2.0f * kPi); // in bins
+        v.synMag[k] = 0.0f;
+        v.synFreq[k] = 0.0f;
+    }
+    for (int k = 0; k <= half; ++k) {
+        const int j = int(k * ratio + 0.5f);
+        if (j > half) break;
+        v.synMag[j] += v.anaMag[k];
+        v.synFreq[j] = v.anaFreq[k] * ratio;
+    }
+    for (int k = 0; k <= half; ++k) {
+        v.sumPhase[k] += (v.synFreq[k] - k) * 2.0f * kPi / kPvOversample + k * expct;
+        v.sumPhase[k] -= 2.0f * kPi * floorf(v.sumPhase[k] / (2.0f * kPi));
+        v.re[k] = v.synMag[k] * cosf(v.sumPhase[k]);
+        v.im[k] = v.synMag[k] * sinf(v.sumPhase[k]);
+    }
+    for (int k = half + 1; k < N; ++k) { v.re[k] = 0.0f; v.im[k] = 0.0f; }
+    s.fft.run(v.re.data(), v.im.data(), true);
+
+    const float scale = 2.0f / (half * kPvOversample);
+    for (int k = 0; k < N; ++k) v.accum[k] += s.pvWindow[k] * v.re[k] * scale;
+    for (int k = 0; k < hop; ++k) v.outFifo[k] = v.accum[k];
+    for (int k = 0; k < N; ++k) v.accum[k] = v.accum[k + hop];
+    for (int k = 0; k < N - hop; ++k) v.inFifo[k] = v.inFifo[k + hop];
+}
+
+static inline void pv_run(HarmonizerState& s, PvVoice& v, float ratio, const float* in, uint32_t frames, float* out) {
+    const int latency = kPvSize - kPvSize / kPvOversample;
+    for (uint32_t i = 0; i < frames; ++i) {
+        v.inFifo[v.rover] = in[i];
+        out[i] = v.outFifo[v.rover - latency];
+        if (++v.rover >= kPvSize) {
+            v.rover = latency;
+            pv_frame(s, v, ratio);
+        }
+    }
+}
+
+// Adds the harmony voices (panned) to `dryL`/`dryR`. `in` is the mono voice
+// for this block, `t0` its absolute index, `hz` the current fundamental.
+static inline void harmonizer_process(HarmonizerState& s, const HarmonizerParams& p, const float* in,
+                                      float* dryL, float* dryR, uint32_t frames,
+                                      uint64_t t0, float hz, float sampleRate) {
+    const uint32_t mask = s.mask;
+    for (uint32_t i = 0; i < frames; ++i) s.history[(t0 + i) & mask] = in[i];
+
+    for (int v = 0; v < kHarmVoices; ++v) s.voiceGain[v] = 0.0f;
+    if (!p.enabled.load(std::memory_order_relaxed)) return;
+
+    const bool hq = p.highQuality.load(std::memory_order_relaxed);
+    if (hq != s.wasHighQuality) {
+        for (int v = 0; v < kHarmVoices; ++v) { s.psola[v] = PsolaVoice{}; s.pv[v].init(); }
+        s.wasHighQuality = hq;
+    }
+    const float period = sampleRate / std::fmax(hz, kHarmMinHz);
+
+    for (uint32_t base = 0; base < frames; base += kHarmMaxBlock) {
+        const uint32_t n = frames - base < kHarmMaxBlock ? frames - base : kHarmMaxBlock;
+        for (int v = 0; v < kHarmVoices; ++v) {
+            const HarmonyVoiceParams& vp = p.voice[v];
+            const float level = vp.level.load(std::memory_order_relaxed);
+            if (level <= 0.0f) continue;
+            const float ratio = powf(2.0f, vp.semitones.load(std::memory_order_relaxed) / 12.0f);
+            float* out = s.scratch[v];
+            if (hq) pv_run(s, s.pv[v], ratio, in + base, n, out);
+            else    psola_run(s, s.psola[v], ratio, period, t0 + base, n, out);
+
+            s.voiceGain[v] = level;
+            const float pan = std::fmax(-1.0f, std::fmin(1.0f, vp.pan.load(std::memory_order_relaxed)));
+            const float gl = level * sqrtf(0.5f * (1.0f - pan));
+            const float gr = level * sqrtf(0.5f * (1.0f + pan));
+            for (uint32_t i = 0; i < n; ++i) {
+                dryL[base + i] += gl * out[i];
+                dryR[base + i] += gr * out[i];
+            }
+        }
+    }
+}
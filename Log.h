@@ -0,0 +1,204 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// ------------------------------
+// Asynchronous logger: binary records now, text later
+// ------------------------------
+//
+// log_event copies a format pointer and up to four arguments into a
+// fixed-size record in the calling thread's own ring: no formatting, no
+// locks, no allocation, no I/O, so the audio thread can log too. One
+// background thread drains every ring, formats the records printf-style and
+// writes them out. A full ring drops the record and counts it.
+//
+// Format strings must be literals (the pointer is kept, not the text), as
+// must %s arguments. Conversions: %d %i %u %x %X %c, %f %e %g, %s, %%; the
+// width/precision flags pass through, length modifiers are not needed.
+
+static constexpr uint32_t kLogRingSize = 256;  // records per thread (power of two)
+static constexpr int      kLogThreads = 16;    // threads that can log
+static constexpr int      kLogArgs = 4;
+
+enum class LogLevel : uint8_t { Info, Warn, Error };
+
+struct LogArg {
+    enum Kind : uint8_t { None, Int, Uint, Real, Str } kind = None;
+    union { int64_t i; uint64_t u; double d; const char* s; };
+
+    LogArg() : i(0) {}
+    template <class T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+    LogArg(T v) : kind(Int), i(int64_t(v)) {}
+    template <class T, typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value, int>::type = 0>
+    LogArg(T v) : kind(Uint), u(uint64_t(v)) {}
+    LogArg(double v) : kind(Real), d(v) {}
+    LogArg(const char* v) : kind(Str), s(v) {}
+};
+
+struct LogRecord {
+    int64_t     ns = 0;          // steady clock
+    const char* fmt = nullptr;
+    LogLevel    level = LogLevel::Info;
+    LogArg      args[kLogArgs];
+};
+
+struct LogRing {
+    LogRecord                  rec[kLogRingSize];
+    const char*                thread = nullptr;  // name, set by its owner
+    alignas(64) std::atomic<uint32_t> head{ 0 };  // owner thread
+    alignas(64) std::atomic<uint32_t> tail{ 0 };  // writer thread
+    std::atomic<uint32_t>      dropped{ 0 };
+};
+
+struct Logger {
+    LogRing               rings[kLogThreads];
+    std::atomic<int>      claimed{ 0 };
+    std::atomic<uint32_t> unclaimed{ 0 };  // records from threads past kLogThreads
+};
+
+static inline int64_t log_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The calling thread's ring, claimed on first use (one Logger per process)
+static inline LogRing* log_ring(Logger& l) {
+    static thread_local LogRing* ring = nullptr;
+    if (!ring) {
+        const int i = l.claimed.fetch_add(1, std::memory_order_relaxed);
+        if (i >= kLogThreads) return nullptr;
+        ring = &l.rings[i];
+    }
+    return ring;
+}
+
+// Name the calling thread in the log (a literal)
+static inline void log_thread_name(Logger& l, const char* name) {
+    if (LogRing* r = log_ring(l)) r->thread = name;
+}
+
+// Any thread, wait-free
+template <class... A>
+static inline void log_event(Logger& l, LogLevel level, const char* fmt, A... args) {
+    static_assert(sizeof...(A) <= kLogArgs, "too many log arguments");
+    LogRing* r = log_ring(l);
+    if (!r) { l.unclaimed.fetch_add(1, std::memory_order_relaxed); return; }
+    const uint32_t w = r->head.load(std::memory_order_relaxed);
+    if (w - r->tail.load(std::memory_order_acquire) >= kLogRingSize) {
+        r->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    LogRecord& rec = r->rec[w & (kLogRingSize - 1)];
+    rec.ns = log_now_ns();
+    rec.fmt = fmt;
+    rec.level = level;
+    const LogArg a[kLogArgs + 1] = { LogArg(args)... };
+    for (int i = 0; i < kLogArgs; ++i) rec.args[i] = a[i];
+    r->head.store(w + 1, std::memory_order_release);
+}
+
+// Writer thread: the format with its arguments substituted
+static inline std::string log_format(const LogRecord& rec) {
+    std::string out;
+    char piece[256];
+    int next = 0;
+    for (const char* p = rec.fmt; *p; ++p) {
+        if (*p != '%') { out += *p; continue; }
+        if (p[1] == '%') { out += '%'; ++p; continue; }
+        // Copy the spec up to its conversion letter, then print the argument
+        char spec[32] = "%";
+        size_t n = 1;
+        const char* q = p + 1;
+        while (*q && strchr("-+ #0123456789.", *q) && n < sizeof(spec) - 4) spec[n++] = *q++;
+        const char conv = *q;
+        if (!conv) break;
+        p = q;
+        const LogArg& a = next < kLogArgs ? rec.args[next++] : LogArg();
+        if (a.kind == LogArg::None) { out += "(missing)"; continue; }
+        const bool real = conv == 'f' || conv == 'e' || conv == 'g';
+        if (conv == 's') {
+            spec[n++] = 's'; spec[n] = 0;
+            snprintf(piece, sizeof(piece), spec, a.kind == LogArg::Str && a.s ? a.s : "(?)");
+        } else if (real) {
+            spec[n++] = conv; spec[n] = 0;
+            const double v = a.kind == LogArg::Real ? a.d : a.kind == LogArg::Int ? double(a.i) : double(a.u);
+            snprintf(piece, sizeof(piece), spec, v);
+        } else if (conv == 'c') {
+            spec[n++] = 'c'; spec[n] = 0;
+            snprintf(piece, sizeof(piece), spec, int(a.i));
+        } else {
+            // Integers print as 64-bit; unsigned conversions take the raw bits
+            spec[n++] = 'l'; spec[n++] = 'l';
+            spec[n++] = (conv == 'x' || conv == 'X' || conv == 'u') ? conv : 'd'; spec[n] = 0;
+            if (conv == 'x' || conv == 'X' || conv == 'u')
+                snprintf(piece, sizeof(piece), spec, (unsigned long long)(a.kind == LogArg::Real ? uint64_t(a.d) : a.u));
+            else
+                snprintf(piece, sizeof(piece), spec, (long long)(a.kind == LogArg::Real ? int64_t(a.d) : a.i));
+        }
+        out += piece;
+    }
+    return out;
+}
+
+// Writer thread: take every waiting record, oldest first across threads.
+// Drop counts are reported as records of their own.
+static inline void log_drain(Logger& l, std::vector<LogRecord>& out, std::vector<const char*>& threads) {
+    out.clear();
+    threads.clear();
+    const int n = std::min(kLogThreads, l.claimed.load(std::memory_order_acquire));
+    for (int i = 0; i < n; ++i) {
+        LogRing& r = l.rings[i];
+        const uint32_t head = r.head.load(std::memory_order_acquire);
+        uint32_t tail = r.tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            out.push_back(r.rec[tail & (kLogRingSize - 1)]);
+            threads.push_back(r.thread);
+        }
+        r.tail.store(tail, std::memory_order_release);
+        if (const uint32_t lost = r.dropped.exchange(0, std::memory_order_relaxed)) {
+            LogRecord d;
+            d.ns = log_now_ns();
+            d.fmt = "log: %u records dropped (ring full)";
+            d.level = LogLevel::Warn;
+            d.args[0] = LogArg(lost);
+            out.push_back(d);
+            threads.push_back(r.thread);
+        }
+    }
+    if (const uint32_t lost = l.unclaimed.exchange(0, std::memory_order_relaxed)) {
+        LogRecord d;
+        d.ns = log_now_ns();
+        d.fmt = "log: %u records dropped (no ring left for their thread)";
+        d.level = LogLevel::Warn;
+        d.args[0] = LogArg(lost);
+        out.push_back(d);
+        threads.push_back(nullptr);
+    }
+    // Oldest first, carrying the thread names along
+    std::vector<size_t> order(out.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return out[a].ns < out[b].ns; });
+    std::vector<LogRecord> sorted;
+    std::vector<const char*> names;
+    sorted.reserve(out.size());
+    names.reserve(out.size());
+    for (size_t i : order) { sorted.push_back(out[i]); names.push_back(threads[i]); }
+    out.swap(sorted);
+    threads.swap(names);
+}
+
+// One line of text: seconds since `originNs`, level, thread, message
+static inline std::string log_line(const LogRecord& rec, const char* thread, int64_t originNs) {
+    static const char* const kLevels[] = { "info ", "warn ", "error" };
+    char head[64];
+    snprintf(head, sizeof(head), "%10.3f %s [%s] ", double(rec.ns - originNs) * 1e-9,
+        kLevels[int(rec.level)], thread ? thread : "?");
+    return head + log_format(rec) + "\n";
+}
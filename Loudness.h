@@ -0,0 +1,210 @@
+#pragma once
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// ------------------------------
+// Loudness metering (ITU-R BS.1770 / EBU R128)
+// ------------------------------
+//
+// Runs off the audio thread. Stereo frames are K-weighted with the two
+// stages in one SSE register (lane 0 = L, lane 1 = R). Mean square is
+// summed in 100 ms sub-blocks. Momentary is the last 4 sub-blocks,
+// short-term the last 30. Integrated loudness gates 400 ms blocks
+// (100 ms hop) at -70 LUFS absolute and -10 LU relative; the blocks are
+// kept as a 0.1 LU histogram, so memory and work per block stay fixed
+// however long the take runs (as libebur128 does). True peak
+// upsamples 4x with a polyphase FIR, one phase per lane.
+
+static constexpr double kPiD = 3.14159265358979323846;
+static constexpr float kLufsFloor = -120.0f;    // reported for silence
+static constexpr int   kLoudSubBlocks = 30;     // 3 s of 100 ms sub-blocks
+static constexpr int   kTruePeakTaps = 12;      // per phase (48-tap prototype)
+static constexpr float kLoudGateLufs = -70.0f;  // absolute gate, histogram floor
+static constexpr int   kLoudBins = 750;         // 0.1 LU bins, -70 to +5 LUFS
+
+struct LoudnessReadout {
+    std::atomic<float> momentary{ kLufsFloor };
+    std::atomic<float> shortTerm{ kLufsFloor };
+    std::atomic<float> integrated{ kLufsFloor };
+    std::atomic<float> truePeakDb{ kLufsFloor }; // max since reset, dBTP
+    std::atomic<bool>  resetRequest{ false };
+};
+
+struct LoudnessMeter {
+    // K-weighting: stage 1 high shelf, stage 2 RLB high-pass (TDF-II)
+    __m128 b0[2], b1[2], b2[2], a1[2], a2[2], z1[2], z2[2];
+    __m128   acc;                 // sum of squares, current sub-block
+    uint32_t hop = 4800, count = 0;
+    float    sub[kLoudSubBlocks]; // sub-block mean squares (L + R)
+    int      subCount = 0, subPos = 0;
+    // 400 ms blocks above the absolute gate: energy and count per bin,
+    // plus the totals for the relative gate
+    double   binEnergy[kLoudBins];
+    uint32_t binCount[kLoudBins];
+    double   blockEnergy = 0.0;
+    uint32_t blockCount = 0;
+    // True peak: lanes are the 4 output phases
+    __m128   tp[kTruePeakTaps];
+    float    hist[2][2 * kTruePeakTaps]; // per channel, written twice (no wrap)
+    int      histPos = 0;
+    float    peak = 0.0f;
+    float    momentary = kLufsFloor, shortTerm = kLufsFloor, integrated = kLufsFloor;
+};
+
+static inline float lufs_from_power(double p) {
+    return p > 1e-12 ? float(-0.691 + 10.0 * log10(p)) : kLufsFloor;
+}
+
+static inline void loudness_reset(LoudnessMeter& m) {
+    for (int s = 0; s < 2; ++s) m.z1[s] = m.z2[s] = _mm_setzero_ps();
+    m.acc = _mm_setzero_ps();
+    m.count = 0;
+    m.subCount = m.subPos = 0;
+    memset(m.binEnergy, 0, sizeof(m.binEnergy));
+    memset(m.binCount, 0, sizeof(m.binCount));
+    m.blockEnergy = 0.0;
+    m.blockCount = 0;
+    memset(m.hist, 0, sizeof(m.hist));
+    m.histPos = 0;
+    m.peak = 0.0f;
+    m.momentary = m.shortTerm = m.integrated = kLufsFloor;
+}
+
+static inline void loudness_init(LoudnessMeter& m, float sampleRate) {
+    // Filter definitions from BS.1770 re-derived for any rate; at 48 kHz they
+    // reproduce the published coefficients.
+    const double fs = sampleRate;
+    {   // High shelf, +4 dB above ~1.7 kHz
+        const double f0 = 1681.974450955533, G = 3.999843853973347, Q = 0.7071752369554196;
+        const double K = tan(kPiD * f0 / fs), Vh = pow(10.0, G / 20.0), Vb = pow(Vh, 0.4996667741545416);
+        const double a0 = 1.0 + K / Q + K * K;
+        m.b0[0] = _mm_set1_ps(float((Vh + Vb * K / Q + K * K) / a0));
+        m.b1[0] = _mm_set1_ps(float(2.0 * (K * K - Vh) / a0));
+        m.b2[0] = _mm_set1_ps(float((Vh - Vb * K / Q + K * K) / a0));
+        m.a1[0] = _mm_set1_ps(float(2.0 * (K * K - 1.0) / a0));
+        m.a2[0] = _mm_set1_ps(float((1.0 - K / Q + K * K) / a0));
+    }
+    {   // RLB high-pass at ~38 Hz
+        const double f0 = 38.13547087602444, Q = 0.5003270373238773;
+        const double K = tan(kPiD * f0 / fs);
+        const double a0 = 1.0 + K / Q + K * K;
+        m.b0[1] = _mm_set1_ps(1.0f);
+        m.b1[1] = _mm_set1_ps(-2.0f);
+        m.b2[1] = _mm_set1_ps(1.0f);
+        m.a1[1] = _mm_set1_ps(float(2.0 * (K * K - 1.0) / a0));
+        m.a2[1] = _mm_set1_ps(float((1.0 - K / Q + K * K) / a0));
+    }
+    m.hop = uint32_t(sampleRate * 0.1f);
+
+    // 4x interpolator: Hann-windowed sinc, each phase normalised to unity DC
+    const int n = 4 * kTruePeakTaps;
+    alignas(16) float phase[kTruePeakTaps][4];
+    for (int p = 0; p < 4; ++p) {
+        double sum = 0.0;
+        for (int k = 0; k < kTruePeakTaps; ++k) {
+            const double t = (4 * k + p - (n - 1) * 0.5) / 4.0;
+            const double sinc = fabs(t) < 1e-9 ? 1.0 : sin(kPiD * t) / (kPiD * t);
+            const double w = 0.5 - 0.5 * cos(2.0 * kPiD * (4 * k + p + 0.5) / n);
+            phase[k][p] = float(sinc * w);
+            sum += sinc * w;
+        }
+        for (int k = 0; k < kTruePeakTaps; ++k) phase[k][p] = float(phase[k][p] / sum);
+    }
+    for (int k = 0; k < kTruePeakTaps; ++k) m.tp[k] = _mm_load_ps(phase[k]);
+    loudness_reset(m);
+}
+
+static inline int loudness_bin(float lufs) {
+    return std::min(kLoudBins - 1, std::max(0, int((lufs - kLoudGateLufs) * 10.0f)));
+}
+
+// Gated mean over the histogram. The relative gate falls on a bin edge, so
+// blocks within 0.1 LU of it may land either side.
+static inline float loudness_integrate(const LoudnessMeter& m) {
+    if (!m.blockCount) return kLufsFloor;
+    // Relative gate: 10 LU below the absolute-gated loudness
+    const float gate = lufs_from_power(m.blockEnergy / double(m.blockCount)) - 10.0f;
+    double gated = 0.0;
+    uint32_t count = 0;
+    for (int b = loudness_bin(gate); b < kLoudBins; ++b) {
+        gated += m.binEnergy[b];
+        count += m.binCount[b];
+    }
+    return count ? lufs_from_power(gated / double(count)) : kLufsFloor;
+}
+
+static inline void loudness_sub_block(LoudnessMeter& m) {
+    alignas(16) float a[4];
+    _mm_store_ps(a, m.acc);
+    m.sub[m.subPos] = (a[0] + a[1]) / float(m.hop);
+    m.subPos = (m.subPos + 1) % kLoudSubBlocks;
+    m.subCount = std::min(m.subCount + 1, kLoudSubBlocks);
+    m.acc = _mm_setzero_ps();
+    m.count = 0;
+
+    double momentary = 0.0, shortTerm = 0.0;
+    for (int k = 0; k < m.subCount; ++k) {
+        const float e = m.sub[(m.subPos - 1 - k + kLoudSubBlocks) % kLoudSubBlocks];
+        if (k < 4) momentary += e;
+        shortTerm += e;
+    }
+    momentary /= double(std::min(m.subCount, 4));
+    shortTerm /= double(m.subCount);
+    m.momentary = lufs_from_power(momentary);
+    m.shortTerm = lufs_from_power(shortTerm);
+
+    // Each full 400 ms window is a gating block (75 % overlap)
+    if (m.subCount >= 4 && m.momentary > kLoudGateLufs) {
+        const int b = loudness_bin(m.momentary);
+        m.binEnergy[b] += momentary;
+        ++m.binCount[b];
+        m.blockEnergy += momentary;
+        ++m.blockCount;
+        m.integrated = loudness_integrate(m);
+    }
+}
+
+// Interleaved stereo in
+static inline void loudness_process(LoudnessMeter& m, const float* stereo, uint32_t frames) {
+    __m128 peak = _mm_set1_ps(m.peak);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    for (uint32_t i = 0; i < frames; ++i) {
+        const float l = stereo[2 * i], r = stereo[2 * i + 1];
+
+        // True peak: newest sample first, both channels
+        m.histPos = (m.histPos + kTruePeakTaps - 1) % kTruePeakTaps;
+        m.hist[0][m.histPos] = m.hist[0][m.histPos + kTruePeakTaps] = l;
+        m.hist[1][m.histPos] = m.hist[1][m.histPos + kTruePeakTaps] = r;
+        const float* hl = &m.hist[0][m.histPos];
+        const float* hr = &m.hist[1][m.histPos];
+        __m128 yl = _mm_setzero_ps(), yr = _mm_setzero_ps();
+        for (int k = 0; k < kTruePeakTaps; ++k) {
+            yl = _mm_add_ps(yl, _mm_mul_ps(m.tp[k], _mm_set1_ps(hl[k])));
+            yr = _mm_add_ps(yr, _mm_mul_ps(m.tp[k], _mm_set1_ps(hr[k])));
+        }
+        peak = _mm_max_ps(peak, _mm_max_ps(_mm_andnot_ps(sign, yl), _mm_andnot_ps(sign, yr)));
+
+        // K-weighting, L/R in lanes
+        __m128 x = _mm_setr_ps(l, r, 0.0f, 0.0f);
+        for (int s = 0; s < 2; ++s) {
+            const __m128 y = _mm_add_ps(_mm_mul_ps(m.b0[s], x), m.z1[s]);
+            m.z1[s] = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(m.b1[s], x), m.z2[s]), _mm_mul_ps(m.a1[s], y));
+            m.z2[s] = _mm_sub_ps(_mm_mul_ps(m.b2[s], x), _mm_mul_ps(m.a2[s], y));
+            x = y;
+        }
+        m.acc = _mm_add_ps(m.acc, _mm_mul_ps(x, x));
+        if (++m.count == m.hop) loudness_sub_block(m);
+    }
+    // Fold the four phases
+    peak = _mm_max_ps(peak, _mm_movehl_ps(peak, peak));
+    peak = _mm_max_ss(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 1, 1, 1)));
+    m.peak = _mm_cvtss_f32(peak);
+}
+
+static inline float loudness_true_peak_db(const LoudnessMeter& m) {
+    return m.peak > 1e-6f ? 20.0f * log10f(m.peak) : kLufsFloor;
+}
@@ -0,0 +1,251 @@
+#pragma once
+#include <xmmintrin.h>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+// ------------------------------
+// Parametric EQ: biquad cascade, SIMD across channel lanes
+// ------------------------------
+//
+// Audio is carried through the output chain as 4-lane frames (lane 0 = L,
+// lane 1 = R, lanes 2..3 spare). Each biquad stage runs on a whole frame in
+// one SSE register, so every channel is filtered for the cost of one.
+
+enum class EqBandType : int { HighPass = 0, LowShelf, Peak, HighShelf, LowPass };
+
+static constexpr int kEqBands = 6;
+
+struct EqBandParams {
+    std::atomic<int>   type{ int(EqBandType::Peak) };
+    std::atomic<float> hz{ 1000.0f };
+    std::atomic<float> gainDb{ 0.0f };
+    std::atomic<float> q{ 0.707f };
+    std::atomic<bool>  enabled{ false };
+};
+
+// Written by the UI thread; bump `version` after editing bands so the audio
+// thread picks the change up at the next block.
+struct EqParams {
+    EqBandParams          band[kEqBands];
+    std::atomic<bool>     bypass{ false };
+    std::atomic<uint32_t> version{ 1 };
+};
+
+struct BiquadCoeffs {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+};
+
+struct EqState {
+    // Current (possibly ramping) coefficients, broadcast across lanes
+    __m128 b0[kEqBands], b1[kEqBands], b2[kEqBands], a1[kEqBands], a2[kEqBands];
+    // Per-sample increments while a ramp is in progress
+    __m128 db0[kEqBands], db1[kEqBands], db2[kEqBands], da1[kEqBands], da2[kEqBands];
+    // Transposed direct form II state
+    __m128 z1[kEqBands], z2[kEqBands];
+    BiquadCoeffs target[kEqBands];
+    uint32_t seenVersion = 0;
+    bool     seenBypass = false;
+    bool     identity = true; // all stages are pass-through and settled
+};
+
+// RBJ cookbook designs
+static inline BiquadCoeffs biquad_design(EqBandType type, float hz, float gainDb, float q, float sampleRate) {
+    hz = std::fmax(10.0f, std::fmin(hz, 0.49f * sampleRate));
+    q = std::fmax(0.1f, q);
+    const float w0 = 6.28318530717958647692f * hz / sampleRate;
+    const float cw = cosf(w0);
+    const float alpha = sinf(w0) / (2.0f * q);
+    const float A = powf(10.0f, gainDb / 40.0f);
+    const float sA2a = 2.0f * sqrtf(A) * alpha;
+
+    float b0, b1, b2, a0, a1, a2;
+    switch (type) {
+    case EqBandType::HighPass:
+        b0 = 0.5f * (1.0f + cw); b1 = -(1.0f + cw); b2 = b0;
+        a0 = 1.0f + alpha; a1 = -2.0f * cw; a2 = 1.0f - alpha;
+        break;
+    case EqBandType::LowPass:
+        b0 = 0.5f * (1.0f - cw); b1 = 1.0f - cw; b2 = b0;
+        a0 = 1.0f + alpha; a1 = -2.0f * cw; a2 = 1.0f - alpha;
+        break;
+    case EqBandType::LowShelf:
+        b0 = A * ((A + 1.0f) - (A - 1.0f) * cw + sA2a);
+        b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cw);
+        b2 = A * ((A + 1.0f) - (A - 1.0f) * cw - sA2a);
+        a0 = (A + 1.0f) + (A - 1.0f) * cw + sA2a;
+        a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cw);
+        a2 = (A + 1.0f) + (A - 1.0f) * cw - sA2a;
+        break;
+    case EqBandType::HighShelf:
+        b0 = A * ((A + 1.0f) + (A - 1.0f) * cw + sA2a);
+        b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cw);
+        b2 = A * ((A + 1.0f) + (A - 1.0f) * cw - sA2a);
+        a0 = (A + 1.0f) - (A - 1.0f) * cw + sA2a;
+        a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cw);
+        a2 = (A + 1.0f) - (A - 1.0f) * cw - sA2a;
+        break;
+    case EqBandType::Peak:
+    default:
+        b0 = 1.0f + alpha * A; b1 = -2.0f * cw; b2 = 1.0f - alpha * A;
+        a0 = 1.0f + alpha / A; a1 = -2.0f * cw; a2 = 1.0f - alpha / A;
+        break;
+    }
+
+    const float inv = 1.0f / a0;
+    BiquadCoeffs c;
+    c.b0 = b0 * inv; c.b1 = b1 * inv; c.b2 = b2 * inv;
+    c.a1 = a1 * inv; c.a2 = a2 * inv;
+    return c;
+}
+
+// One band's settings, as the config file and the host API give them
+struct EqBand {
+    EqBandType type = EqBandType::Peak;
+    float      hz = 1000.0f, gainDb = 0.0f, q = 0.707f;
+    bool       enabled = false;
+};
+
+// Ranges a band is clamped to
+static constexpr float kEqMinHz = 20.0f, kEqMaxHz = 20000.0f;
+static constexpr float kEqMaxGainDb = 24.0f;
+static constexpr float kEqMinQ = 0.1f, kEqMaxQ = 20.0f;
+
+// Room-correction starting point: rumble/ultrasonic guards on, tone bands flat
+static const EqBand kEqDefaultBands[kEqBands] = {
+    { EqBandType::HighPass,  30.0f,    0.0f, 0.707f, true },
+    { EqBandType::LowShelf,  150.0f,   0.0f, 0.707f, true },
+    { EqBandType::Peak,      450.0f,   0.0f, 1.0f,   true },
+    { EqBandType::Peak,      1800.0f,  0.0f, 1.0f,   true },
+    { EqBandType::HighShelf, 6000.0f,  0.0f, 0.707f, true },
+    { EqBandType::LowPass,   18000.0f, 0.0f, 0.707f, true },
+};
+
+// Any thread. Call eq_commit once the bands are written.
+static inline void eq_set_band(EqParams& p, int k, const EqBand& b) {
+    EqBandParams& d = p.band[k];
+    d.type.store(int(b.type));
+    d.hz.store(std::fmax(kEqMinHz, std::fmin(kEqMaxHz, b.hz)));
+    d.gainDb.store(std::fmax(-kEqMaxGainDb, std::fmin(kEqMaxGainDb, b.gainDb)));
+    d.q.store(std::fmax(kEqMinQ, std::fmin(kEqMaxQ, b.q)));
+    d.enabled.store(b.enabled);
+}
+
+// The audio thread redesigns every band (ramped) at its next block
+static inline void eq_commit(EqParams& p) {
+    p.version.fetch_add(1, std::memory_order_release);
+}
+
+static inline void eq_default_bands(EqParams& p) {
+    for (int k = 0; k < kEqBands; ++k) eq_set_band(p, k, kEqDefaultBands[k]);
+    eq_commit(p);
+}
+
+static inline void eq_reset(EqState& s) {
+    const __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+    for (int k = 0; k < kEqBands; ++k) {
+        s.b0[k] = one; s.b1[k] = zero; s.b2[k] = zero; s.a1[k] = zero; s.a2[k] = zero;
+        s.db0[k] = zero; s.db1[k] = zero; s.db2[k] = zero; s.da1[k] = zero; s.da2[k] = zero;
+        s.z1[k] = zero; s.z2[k] = zero;
+        s.target[k] = BiquadCoeffs{};
+    }
+    s.seenVersion = 0;
+    s.seenBypass = false;
+    s.identity = true;
+}
+
+template <bool Ramp>
+static inline void eq_run(EqState& s, float* lanes, uint32_t frames) {
+    for (uint32_t i = 0; i < frames; ++i) {
+        __m128 x = _mm_load_ps(lanes + 4 * i);
+        for (int k = 0; k < kEqBands; ++k) {
+            const __m128 y = _mm_add_ps(_mm_mul_ps(s.b0[k], x), s.z1[k]);
+            s.z1[k] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(s.b1[k], x), _mm_mul_ps(s.a1[k], y)), s.z2[k]);
+            s.z2[k] = _mm_sub_ps(_mm_mul_ps(s.b2[k], x), _mm_mul_ps(s.a2[k], y));
+            x = y;
+            if (Ramp) {
+                s.b0[k] = _mm_add_ps(s.b0[k], s.db0[k]);
+                s.b1[k] = _mm_add_ps(s.b1[k], s.db1[k]);
+                s.b2[k] = _mm_add_ps(s.b2[k], s.db2[k]);
+                s.a1[k] = _mm_add_ps(s.a1[k], s.da1[k]);
+                s.a2[k] = _mm_add_ps(s.a2[k], s.da2[k]);
+            }
+        }
+        _mm_store_ps(lanes + 4 * i, x);
+    }
+}
+
+// True when a parameter change is waiting to be ramped in by eq_process;
+// otherwise the stages hold fixed coefficients (identity, or not)
+static inline bool eq_change_pending(const EqState& s, const EqParams& p) {
+    return p.version.load(std::memory_order_acquire) != s.seenVersion
+        || p.bypass.load(std::memory_order_relaxed) != s.seenBypass;
+}
+
+// One frame through every stage at the current, settled coefficients, for
+// callers that carry their own frames; only when no change is pending
+static inline __m128 eq_frame(EqState& s, __m128 x) {
+    for (int k = 0; k < kEqBands; ++k) {
+        const __m128 y = _mm_add_ps(_mm_mul_ps(s.b0[k], x), s.z1[k]);
+        s.z1[k] = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(s.b1[k], x), _mm_mul_ps(s.a1[k], y)), s.z2[k]);
+        s.z2[k] = _mm_sub_ps(_mm_mul_ps(s.b2[k], x), _mm_mul_ps(s.a2[k], y));
+        x = y;
+    }
+    return x;
+}
+
+// Two interleaved stereo frames [L0 R0 L1 R1] through eq_frame, one after
+// the other, in lanes 0..1 as eq_process carries them
+static inline __m128 eq_stereo_pair(EqState& s, __m128 lr) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 y0 = eq_frame(s, _mm_movelh_ps(lr, zero));
+    const __m128 y1 = eq_frame(s, _mm_movehl_ps(zero, lr));
+    return _mm_movelh_ps(y0, y1);
+}
+
+// Filter `frames` 4-lane frames in place (lanes must be 16-byte aligned).
+// Parameter changes are picked up once per block and the coefficients are
+// interpolated linearly across that block to avoid zipper noise.
+static inline void eq_process(EqState& s, const EqParams& p, float* lanes, uint32_t frames, float sampleRate) {
+    if (frames == 0) return;
+
+    const uint32_t version = p.version.load(std::memory_order_acquire);
+    const bool bypass = p.bypass.load(std::memory_order_relaxed);
+    if (version == s.seenVersion && bypass == s.seenBypass) {
+        if (s.identity) return;
+        eq_run<false>(s, lanes, frames);
+        return;
+    }
+    s.seenVersion = version;
+    s.seenBypass = bypass;
+
+    bool identity = true;
+    for (int k = 0; k < kEqBands; ++k) {
+        const EqBandParams& b = p.band[k];
+        BiquadCoeffs c;
+        if (!bypass && b.enabled.load(std::memory_order_relaxed)) {
+            c = biquad_design(EqBandType(b.type.load(std::memory_order_relaxed)),
+                b.hz.load(std::memory_order_relaxed), b.gainDb.load(std::memory_order_relaxed),
+                b.q.load(std::memory_order_relaxed), sampleRate);
+            identity = false;
+        }
+        s.target[k] = c;
+        const __m128 invN = _mm_set1_ps(1.0f / float(frames));
+        s.db0[k] = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(c.b0), s.b0[k]), invN);
+        s.db1[k] = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(c.b1), s.b1[k]), invN);
+        s.db2[k] = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(c.b2), s.b2[k]), invN);
+        s.da1[k] = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(c.a1), s.a1[k]), invN);
+        s.da2[k] = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(c.a2), s.a2[k]), invN);
+    }
+
+    eq_run<true>(s, lanes, frames);
+
+    // Land exactly on the targets so rounding in the ramp never accumulates
+    for (int k = 0; k < kEqBands; ++k) {
+        const BiquadCoeffs& c = s.target[k];
+        s.b0[k] = _mm_set1_ps(c.b0); s.b1[k] = _mm_set1_ps(c.b1); s.b2[k] = _mm_set1_ps(c.b2);
+        s.a1[k] = _mm_set1_ps(c.a1); s.a2[k] = _mm_set1_ps(c.a2);
+        if (identity) { s.z1[k] = _mm_setzero_ps(); s.z2[k] = _mm_setzero_ps(); }
+    }
+    s.identity = identity;
+}
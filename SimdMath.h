@@ -0,0 +1,72 @@
+#pragma once
+#include <emmintrin.h>
+
+// ------------------------------
+// Fast SSE2 math approximations
+// ------------------------------
+//
+// Used where whole blocks of gains/levels are converted between the linear
+// and log domains; accurate to a few thousandths of a dB, far cheaper than
+// calling logf/expf per sample.
+
+// log2(x) for x > 0; abs error ~2e-5 (denormals flush to the exponent floor)
+static inline __m128 fast_log2_ps(__m128 x) {
+    const __m128i bits = _mm_castps_si128(x);
+    const __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    const __m128 m = _mm_castsi128_ps(_mm_or_si128(
+        _mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000))); // [1,2)
+    const __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+
+    // log2(1 + t) on [0,1), least-squares fit
+    __m128 p = _mm_set1_ps(0.0452682923f);
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.193516524f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(0.415245560f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(-0.708865217f));
+    p = _mm_add_ps(_mm_mul_ps(p, t), _mm_set1_ps(1.44187990f));
+    p = _mm_mul_ps(p, t);
+    return _mm_add_ps(e, p);
+}
+
+// 2^x, x clamped to [-126, 126]; relative error ~4e-6
+static inline __m128 fast_exp2_ps(__m128 x) {
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(126.0f));
+
+    // floor(x): truncate, then step down for negative non-integers
+    __m128 fl = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    fl = _mm_sub_ps(fl, _mm_and_ps(_mm_cmpgt_ps(fl, x), _mm_set1_ps(1.0f)));
+    const __m128 f = _mm_sub_ps(x, fl); // [0,1)
+
+    // 2^f - 1 on [0,1), least-squares fit
+    __m128 p = _mm_set1_ps(0.0135816641f);
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.0519479528f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.241448660f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.693017513f));
+    p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+    const __m128i ebits = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(fl), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(p, _mm_castsi128_ps(ebits));
+}
+
+static inline __m128 abs_ps(__m128 x) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+}
+
+// Same rational tanh as fast_tanhf, with the input clamped to +-3 where the
+// curve reaches +-1, so it is a true (bounded) saturator.
+static inline __m128 fast_tanh_ps(__m128 x) {
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-3.0f)), _mm_set1_ps(3.0f));
+    const __m128 x2 = _mm_mul_ps(x, x);
+    const __m128 num = _mm_mul_ps(x, _mm_add_ps(_mm_set1_ps(27.0f), x2));
+    const __m128 den = _mm_add_ps(_mm_set1_ps(27.0f), _mm_mul_ps(_mm_set1_ps(9.0f), x2));
+    return _mm_div_ps(num, den);
+}
+
+// Scalar conveniences for per-block conversions
+static inline float fast_log2f(float x) { return _mm_cvtss_f32(fast_log2_ps(_mm_set_ss(x))); }
+static inline float fast_exp2f(float x) { return _mm_cvtss_f32(fast_exp2_ps(_mm_set_ss(x))); }
+
+static constexpr float kDbPerLog2 = 6.02059991f;  // 20*log10(2)
+static constexpr float kLog2PerDb = 0.166096405f; // 1 / kDbPerLog2
+
+static inline float fast_db_to_gain(float db) { return fast_exp2f(db * kLog2PerDb); }
+static inline float fast_gain_to_db(float g) { return kDbPerLog2 * fast_log2f(g); }
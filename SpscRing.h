@@ -0,0 +1,86 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ------------------------------
+// Single-producer/single-consumer float ring
+// ------------------------------
+//
+// The audio thread writes, one other thread reads; neither ever blocks. A
+// write that does not fit is dropped whole (and counted) rather than
+// waiting, so the audio thread never stalls on a slow consumer.
+
+struct SpscRing {
+    std::vector<float> buf;
+    uint32_t mask = 0;
+    alignas(64) std::atomic<uint32_t> head{ 0 };  // producer position
+    alignas(64) std::atomic<uint32_t> tail{ 0 };  // consumer position
+    std::atomic<uint32_t> dropped{ 0 };           // floats lost to a full ring
+};
+
+// Size is rounded up to a power of two; call before either side runs
+static inline void spsc_init(SpscRing& r, uint32_t minFloats) {
+    uint32_t size = 1;
+    while (size < minFloats) size <<= 1;
+    r.buf.assign(size, 0.0f);
+    r.mask = size - 1;
+    r.head.store(0, std::memory_order_relaxed);
+    r.tail.store(0, std::memory_order_relaxed);
+    r.dropped.store(0, std::memory_order_relaxed);
+}
+
+// Producer, in place: reserve room for a whole record, fill it with
+// spsc_put/spsc_at at offsets from the reservation, then publish it with
+// one spsc_commit. The consumer never sees a partial record.
+static inline bool spsc_reserve(SpscRing& r, uint32_t n) {
+    const uint32_t w = r.head.load(std::memory_order_relaxed);
+    const uint32_t rd = r.tail.load(std::memory_order_acquire);
+    if (n > r.mask + 1 - (w - rd)) {
+        r.dropped.fetch_add(n, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+static inline void spsc_put(SpscRing& r, uint32_t offset, const float* in, uint32_t n) {
+    const uint32_t start = (r.head.load(std::memory_order_relaxed) + offset) & r.mask;
+    const uint32_t first = std::min(n, r.mask + 1 - start);
+    memcpy(&r.buf[start], in, first * sizeof(float));
+    if (first < n) memcpy(&r.buf[0], in + first, (n - first) * sizeof(float));
+}
+
+static inline float& spsc_at(SpscRing& r, uint32_t offset) {
+    return r.buf[(r.head.load(std::memory_order_relaxed) + offset) & r.mask];
+}
+
+static inline void spsc_commit(SpscRing& r, uint32_t n) {
+    r.head.store(r.head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+}
+
+// Producer: all `n` floats or none
+static inline bool spsc_write(SpscRing& r, const float* in, uint32_t n) {
+    if (!spsc_reserve(r, n)) return false;
+    spsc_put(r, 0, in, n);
+    spsc_commit(r, n);
+    return true;
+}
+
+static inline uint32_t spsc_available(const SpscRing& r) {
+    return r.head.load(std::memory_order_acquire) - r.tail.load(std::memory_order_relaxed);
+}
+
+// Consumer: up to `maxFloats`, returns the count read
+static inline uint32_t spsc_read(SpscRing& r, float* out, uint32_t maxFloats) {
+    const uint32_t rd = r.tail.load(std::memory_order_relaxed);
+    const uint32_t w = r.head.load(std::memory_order_acquire);
+    const uint32_t n = std::min(maxFloats, w - rd);
+    const uint32_t start = rd & r.mask;
+    const uint32_t first = std::min(n, r.mask + 1 - start);
+    memcpy(out, &r.buf[start], first * sizeof(float));
+    if (first < n) memcpy(out + first, &r.buf[0], (n - first) * sizeof(float));
+    r.tail.store(rd + n, std::memory_order_release);
+    return n;
+}
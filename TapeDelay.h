@@ -0,0 +1,165 @@
+#pragma once
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "DelayLine.h"
+#include "SimdMath.h"
+
+// ------------------------------
+// Tape-style delay: wow/flutter, filtered saturating feedback, ping-pong
+// ------------------------------
+//
+// Block structure: delay times for the block are computed first, both taps
+// are read with the interpolating block kernel, then the feedback path runs
+// per frame with L/R in one SSE register, and finally the block is written
+// back. Minimum delay is therefore one block (~3 ms), irrelevant for echoes.
+
+static constexpr float    kTapeMaxSeconds = 2.5f;
+static constexpr uint32_t kTapeChunk = 128;
+static constexpr float    kTapeFadeMs = 5.0f;    // send ramp when switched on or off
+static constexpr float    kTapeSilence = 1e-5f;  // echo level (-100 dB) taken as gone
+
+struct TapeDelayParams {
+    std::atomic<bool>  enabled{ false };
+    std::atomic<bool>  sync{ true };         // tempo-synced time
+    std::atomic<float> bpm{ 120.0f };
+    std::atomic<float> beats{ 0.75f };       // dotted eighth
+    std::atomic<float> timeMs{ 350.0f };     // used when not synced
+    std::atomic<float> feedback{ 0.45f };
+    std::atomic<float> toneHz{ 3200.0f };    // feedback low-pass
+    std::atomic<float> lowCutHz{ 150.0f };   // feedback high-pass
+    std::atomic<float> drive{ 1.5f };        // tape saturation
+    std::atomic<float> wowMs{ 0.6f };        // slow drift depth
+    std::atomic<float> flutterMs{ 0.06f };   // fast wobble depth
+    std::atomic<float> mix{ 0.35f };
+    std::atomic<bool>  pingPong{ true };
+};
+
+// Random target every `period` samples, followed by two one-poles
+struct SmoothRandom {
+    float    target = 0.0f, mid = 0.0f, value = 0.0f;
+    uint32_t countdown = 0;
+};
+
+struct TapeDelayState {
+    DelayLine    l, r;
+    float        delay = 0.0f;      // smoothed base delay in frames
+    SmoothRandom wow, flutter;
+    uint32_t     seed = 0x2545F491u;
+    __m128       lp, hp;            // feedback filters, lanes L/R
+    float        send = 0.0f;       // input into the tape, ramped 0..1
+    uint32_t     quiet = 0;         // frames since the echoes were last audible
+    bool         active = false;
+    float        times[kTapeChunk], tapL[kTapeChunk], tapR[kTapeChunk];
+    float        wL[kTapeChunk], wR[kTapeChunk];
+};
+
+static inline void tape_delay_init(TapeDelayState& s, float sampleRate) {
+    delay_init(s.l, uint32_t(kTapeMaxSeconds * sampleRate) + 2 * kTapeChunk);
+    delay_init(s.r, uint32_t(kTapeMaxSeconds * sampleRate) + 2 * kTapeChunk);
+    s.delay = 0.0f;
+    s.wow = SmoothRandom{};
+    s.flutter = SmoothRandom{};
+    s.lp = _mm_setzero_ps();
+    s.hp = _mm_setzero_ps();
+}
+
+static inline float smooth_random_step(SmoothRandom& r, uint32_t& seed, uint32_t period, float coeff) {
+    if (r.countdown == 0) {
+        seed = 1664525u * seed + 1013904223u;
+        r.target = (seed >> 8) * (2.0f / 16777216.0f) - 1.0f;
+        r.countdown = period;
+    }
+    --r.countdown;
+    r.mid += coeff * (r.target - r.mid);
+    r.value += coeff * (r.mid - r.value);
+    return r.value;
+}
+
+// dry* in, the echoes alone into wet* (the caller adds them to its own
+// routing). Switching off ramps the send to zero and lets the echoes ring
+// out; returns false once they have, with nothing written.
+static inline bool tape_delay_process(TapeDelayState& s, const TapeDelayParams& p,
+                                      const float* dryL, const float* dryR, float* wetL, float* wetR,
+                                      uint32_t frames, float sampleRate) {
+    const bool on = p.enabled.load(std::memory_order_relaxed);
+    if (!on && !s.active) return false;
+    if (!s.active) { // start from silent tape
+        delay_clear(s.l);
+        delay_clear(s.r);
+        s.delay = 0.0f;
+        s.lp = _mm_setzero_ps();
+        s.hp = _mm_setzero_ps();
+        s.send = 0.0f;
+        s.quiet = 0;
+        s.active = true;
+    }
+
+    const float seconds = p.sync.load(std::memory_order_relaxed)
+        ? p.beats.load(std::memory_order_relaxed) * 60.0f / std::fmax(20.0f, p.bpm.load(std::memory_order_relaxed))
+        : p.timeMs.load(std::memory_order_relaxed) * 0.001f;
+    const float msToFrames = 0.001f * sampleRate;
+    const float wowDepth = p.wowMs.load(std::memory_order_relaxed) * msToFrames;
+    const float flutterDepth = p.flutterMs.load(std::memory_order_relaxed) * msToFrames;
+    const float maxDelay = float(s.l.mask) - 2.0f * kTapeChunk - wowDepth - flutterDepth;
+    const float minDelay = float(kTapeChunk + 4) + wowDepth + flutterDepth;
+    const float target = std::fmin(maxDelay, std::fmax(minDelay, seconds * sampleRate));
+    if (s.delay == 0.0f) s.delay = target;
+
+    const float fb = std::fmin(0.98f, std::fmax(0.0f, p.feedback.load(std::memory_order_relaxed)));
+    const float drive = std::fmax(0.1f, p.drive.load(std::memory_order_relaxed));
+    const float mix = p.mix.load(std::memory_order_relaxed);
+    const bool  pingPong = p.pingPong.load(std::memory_order_relaxed);
+    const float twoPiT = 6.28318530717958647692f / sampleRate;
+    const __m128 aLp = _mm_set1_ps(1.0f - expf(-twoPiT * p.toneHz.load(std::memory_order_relaxed)));
+    const __m128 aHp = _mm_set1_ps(1.0f - expf(-twoPiT * p.lowCutHz.load(std::memory_order_relaxed)));
+    const __m128 vDrive = _mm_set1_ps(drive), vInvDrive = _mm_set1_ps(1.0f / drive);
+    const uint32_t wowPeriod = uint32_t(0.7f * sampleRate), flutterPeriod = uint32_t(0.08f * sampleRate);
+    const float wowCoeff = 1.0f - expf(-twoPiT * 1.2f), flutterCoeff = 1.0f - expf(-twoPiT * 14.0f);
+    const float glide = 1.0f - expf(-1.0f / (0.15f * sampleRate)); // tape-like repitch on time changes
+    const float sendStep = (on ? 1000.0f : -1000.0f) / (kTapeFadeMs * sampleRate);
+
+    for (uint32_t base = 0; base < frames; base += kTapeChunk) {
+        const uint32_t n = std::min(kTapeChunk, frames - base);
+
+        for (uint32_t i = 0; i < n; ++i) {
+            s.delay += glide * (target - s.delay);
+            const float w = smooth_random_step(s.wow, s.seed, wowPeriod, wowCoeff);
+            const float f = smooth_random_step(s.flutter, s.seed, flutterPeriod, flutterCoeff);
+            s.times[i] = s.delay + wowDepth * w + flutterDepth * f;
+        }
+        delay_read_block_interp(s.l, s.times, s.tapL, n);
+        delay_read_block_interp(s.r, s.times, s.tapR, n);
+
+        for (uint32_t i = 0; i < n; ++i) {
+            s.send = std::fmax(0.0f, std::fmin(1.0f, s.send + sendStep));
+            const float inL = s.send * dryL[base + i], inR = s.send * dryR[base + i];
+            const __m128 tap = _mm_setr_ps(s.tapL[i], s.tapR[i], 0.0f, 0.0f);
+            s.lp = _mm_add_ps(s.lp, _mm_mul_ps(aLp, _mm_sub_ps(tap, s.lp)));
+            s.hp = _mm_add_ps(s.hp, _mm_mul_ps(aHp, _mm_sub_ps(s.lp, s.hp)));
+            const __m128 band = _mm_sub_ps(s.lp, s.hp);
+            const __m128 sat = _mm_mul_ps(fast_tanh_ps(_mm_mul_ps(band, vDrive)), vInvDrive);
+            alignas(16) float y[4];
+            _mm_store_ps(y, sat);
+
+            if (pingPong) { // mono in on the left, echoes bounce L -> R -> L
+                s.wL[i] = 0.5f * (inL + inR) + fb * y[1];
+                s.wR[i] = fb * y[0];
+            } else {
+                s.wL[i] = inL + fb * y[0];
+                s.wR[i] = inR + fb * y[1];
+            }
+            wetL[base + i] = mix * y[0];
+            wetR[base + i] = mix * y[1];
+            s.quiet = fabsf(y[0]) + fabsf(y[1]) > kTapeSilence ? 0 : s.quiet + 1;
+        }
+        delay_write_block(s.l, s.wL, n);
+        delay_write_block(s.r, s.wR, n);
+    }
+    // Off, and quiet for longer than the tape holds: nothing is left on it
+    if (!on && s.send == 0.0f && s.quiet > uint32_t(s.delay) + kTapeChunk) s.active = false;
+    return true;
+}
@@ -4,15 +4,49 @@
 #include <mmdeviceapi.h>
 #include <audioclient.h>
 #include <avrt.h>
+#include <shellapi.h>
+#include <dwmapi.h>
+#include <Xinput.h>
+#include <timeapi.h>
+#include <xmmintrin.h>
+#include <algorithm>
 #include <atomic>
 #include <cmath>
 #include <cstdint>
+#include <cstdarg>
+#include <cstdio>
+#include <cwchar>
 #include <vector>
 #include <string>
 
+#include "ParametricEq.h"
+#include "Dynamics.h"
+#include "Harmonizer.h"
+#include "Vocoder.h"
+#include "WavFile.h"
+#include "DelayLine.h"
+#include "TapeDelay.h"
+#include "Gesture.h"
+#include "GainStage.h"
+#include "ControlRate.h"
+#include "SpscRing.h"
+#include "Loudness.h"
+#include "DiskWriter.h"
+#include "ControlQueue.h"
+#include "Canvas.h"
+#include "VoicePool.h"
+#include "Engine.h"
+#include "GestureScript.h"
+#include "Config.h"
+#include "Log.h"
+
 #pragma comment(lib,"Ole32.lib")
 #pragma comment(lib,"Mmdevapi.lib")
 #pragma comment(lib,"Avrt.lib")
+#pragma comment(lib,"Shell32.lib")
+#pragma comment(lib,"Dwmapi.lib")
+#pragma comment(lib,"Xinput.lib")
+#pragma comment(lib,"Winmm.lib")
 
 // Simple HRESULT check macro
 #define CHECKHR(hr) do { if (FAILED(hr)) { goto cleanup; } } while (0)
@@ -21,86 +55,6 @@
 template <class T>
 void SafeRelease(T** ppT) { if (ppT && *ppT) { (*ppT)->Release(); *ppT = nullptr; } }
 
-// ------------------------------
-// Synth parameters and utilities
-// ------------------------------
-
-static constexpr float kSampleRate = 48000.0f;
-static constexpr float kTwoPi = 6.28318530717958647692f;
-static constexpr float kMinHz = 100.0f;
-static constexpr float kMaxHz = 2000.0f;
-
-struct SynthParams {
-    std::atomic<float> targetHz{ 440.0f };
-    std::atomic<float> targetGain{ 0.0f };   // 0..1
-    std::atomic<int>   mode{ 1 };            // 1..4
-    std::atomic<bool>  mute{ false };
-    std::atomic<float> vibratoDepth{ 0.0f }; // 0..1 (depth scaled in synth)
-};
-
-struct SynthState {
-    float phaseA = 0.0f; // main osc
-    float phaseB = 0.0f; // mod osc
-    float smoothHz = 440.0f;
-    float smoothGain = 0.0f;
-    float vibratoPhase = 0.0f;
-    float delayL = 0.0f, delayR = 0.0f; // minimal stereo decorrelation
-    std::vector<float> delayBufL, delayBufR;
-    size_t delayIndex = 0;
-};
-
-static inline float fast_tanhf(float x) {
-    // Rational tanh approximation (sufficient for gentle waveshaping)
-    // tanh(x) ~ x * (27 + x^2) / (27 + 9*x^2)
-    const float x2 = x * x;
-    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
-}
-
-// PolyBLEP-free soft saw/tri hybrid (simple, slightly band-limited by saturation)
-static inline float soft_saw(float phase) {
-    // Map phase to (-1..1) saw, then gently saturate
-    float s = (phase / kTwoPi) * 2.0f - 1.0f; // -1..1 ramp
-    return fast_tanhf(0.8f * s);
-}
-
-static inline float soft_tri(float phase) {
-    float tri = 2.0f * fabsf((phase / kTwoPi) - 0.5f) - 1.0f;
-    return fast_tanhf(0.8f * tri);
-}
-
-static inline float sine(float phase) {
-    return sinf(phase);
-}
-
-static inline float white_noise() {
-    // Simple LCG-based white noise; deterministic enough for demo
-    static uint32_t seed = 0x12345678u;
-    seed = 1664525u * seed + 1013904223u;
-    const float u = (seed & 0x00FFFFFFu) / 16777216.0f; // [0,1)
-    return 2.0f * u - 1.0f; // [-1,1]
-}
-
-// One-pole smoother (slew) for frequency and gain
-static inline float smooth_step(float current, float target, float coeff) {
-    return current + coeff * (target - current);
-}
-
-// Map mouse X (0..W) to logarithmic frequency between kMinHz and kMaxHz
-static inline float map_x_to_hz(int x, int width) {
-    if (width <= 0) return 440.0f;
-    float nx = std::max(0.0f, std::min(1.0f, x / float(width)));
-    // Log mapping: Hz = Min * (Max/Min)^nx
-    float ratio = kMaxHz / kMinHz;
-    return kMinHz * powf(ratio, nx);
-}
-
-// Map mouse Y (0..H) to gain (top loud, bottom quiet); clamp 0..1
-static inline float map_y_to_gain(int y, int height) {
-    if (height <= 0) return 0.0f;
-    float ny = std::max(0.0f, std::min(1.0f, y / float(height)));
-    return 1.0f - ny; // invert (top loud)
-}
-
 // ------------------------------
 // WASAPI infrastructure
 // ------------------------------
@@ -113,48 +67,185 @@ struct WasapiContext {
     HANDLE               hEvent = nullptr;
     WAVEFORMATEX* pMixFmt = nullptr;
     UINT32               bufferFrames = 0;
+    float                bufferMs = 20.0f;    // requested buffer, set before opening (config latency_ms)
+    double               streamLatency = 0.0; // seconds, device side
     HANDLE               hAudioThread = nullptr;
     HANDLE               hAvrt = nullptr;
     std::atomic<bool>    running{ false };
     bool                 coInit = false;
+    // Optional capture stream (vocoder modulator), polled by the audio thread
+    IMMDevice* pCapDev = nullptr;
+    IAudioClient* pCapCli = nullptr;
+    IAudioCaptureClient* pCap = nullptr;
+    WAVEFORMATEX* pCapFmt = nullptr;
 };
 
 // ------------------------------
 // Global app state
 // ------------------------------
 
-static SynthParams gParams;
+// The app runs one engine; these name the parts the UI and threads touch
+static Engine gEngine;
+static SynthParams& gParams = gEngine.params;
+static SynthState& gSynth = gEngine.synth;
+static ControlQueue& gControl = gEngine.control; // every input source pushes here
 static WasapiContext gWASAPI;
-static SynthState gSynth;
 static HWND gHWND = nullptr;
+static Logger gLog;          // any thread; written out by LogThreadMain
+
+// Post-chain analysis: the audio thread taps stereo frames into a ring that
+// a low-priority thread drains for loudness metering
+struct AnalysisContext {
+    SpscRing          tap;
+    LoudnessMeter     meter;
+    LoudnessReadout   readout;
+    HANDLE            hThread = nullptr;
+    std::atomic<bool> running{ false };
+    float             sampleRate = 48000.0f;
+};
+static AnalysisContext gAnalysis;
+static constexpr uint32_t kTapFloats = 1u << 17; // ~1.3 s of stereo at 48 kHz
+
+// Disk recorder: the audio thread copies what it records into a ring once,
+// as records of [take id, payload size, payload]; a low-priority thread owns
+// the files and writes them unbuffered. Records of a stale take are skipped.
+enum class RecordMode : int { Master = 0, Stems, StemFiles };
+
+struct RecorderContext {
+    SpscRing          tap;
+    std::atomic<bool> armed{ false };     // toggled by the UI
+    std::atomic<bool> recording{ false }; // a take is open; the audio thread writes while set
+    std::atomic<int>  requestMode{ 0 };   // RecordMode for the next take
+    std::atomic<int>  mode{ 0 };          // RecordMode of the open take
+    std::atomic<int>  take{ 0 };          // id stamped on records
+    std::atomic<bool> running{ false };
+    HANDLE            hThread = nullptr;
+    int               channels = 2;
+    uint32_t          sampleRate = 48000;
+};
+static RecorderContext gRecorder;
+static constexpr uint32_t kRecordFloats = 1u << 21; // 8 MB: ~2.7 s of 8 ch at 96 kHz
+
+// Stem takes (see StemChannel) are written as one multichannel file or one
+// file per stem
+struct StemFile { const wchar_t* suffix; int first, channels; };
+static const StemFile kStemFiles[] = {
+    { L"voice", kStemVoice, 1 }, { L"harmony1", kStemHarm1, 1 }, { L"harmony2", kStemHarm2, 1 },
+    { L"dry", kStemDryL, 2 }, { L"fx", kStemFxL, 2 }, { L"mix", kStemMixL, 2 },
+};
+static constexpr int kStemFileCount = sizeof(kStemFiles) / sizeof(kStemFiles[0]);
+
+// Command line: /live  /mod <file.wav>  /bench [report.txt]  /loudness <log.csv>  /config <file.cfg>  /log <file.log>
+struct AppOptions {
+    bool         liveInput = false;
+    std::wstring modFile;
+    std::wstring configFile = L"theremin.cfg";
+    std::wstring logFile = L"theremin.log";
+    std::wstring loudnessCsv;  // per-second loudness export, empty = off
+    bool         bench = false;
+    std::wstring benchOut = L"theremin_bench.txt";
+    std::wstring renderScript, renderOut;  // offline render, no window
+};
+static AppOptions gOptions;
+
+
+// Performance-counter ticks to seconds (input timestamps use the same clock)
+static double QpcSeconds(LONGLONG count) {
+    static LARGE_INTEGER freq{};
+    if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+    return double(count) / double(freq.QuadPart);
+}
+
+static double NowSeconds() {
+    LARGE_INTEGER t{};
+    QueryPerformanceCounter(&t);
+    return QpcSeconds(t.QuadPart);
+}
+
+static bool ReadWholeFile(const wchar_t* path, std::vector<uint8_t>& bytes) {
+    HANDLE h = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size{};
+    bool ok = GetFileSizeEx(h, &size) && size.QuadPart > 0 && size.QuadPart < (1ll << 30);
+    if (ok) {
+        bytes.resize(size_t(size.QuadPart));
+        DWORD got = 0;
+        ok = ReadFile(h, bytes.data(), DWORD(bytes.size()), &got, nullptr) && got == bytes.size();
+    }
+    CloseHandle(h);
+    return ok;
+}
+
+static bool WriteWholeFile(const wchar_t* path, const std::string& text) {
+    HANDLE h = CreateFileW(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    DWORD wrote = 0;
+    bool ok = WriteFile(h, text.data(), DWORD(text.size()), &wrote, nullptr) && wrote == text.size();
+    CloseHandle(h);
+    return ok;
+}
+
+// Any time, from the UI thread: the clip is swapped in while the audio
+// thread plays and the old one is freed once it has moved on. Read
+// unbuffered, so a long clip does not push the take out of the file cache.
+static bool LoadModulatorFile(const wchar_t* path, float sampleRate) {
+    std::vector<uint8_t> bytes;
+    if (!disk_read_file(path, bytes)) return false;
+    ModulatorClip* clip = new ModulatorClip();
+    if (!wav_decode_mono(bytes.data(), bytes.size(), sampleRate, clip->samples) || clip->samples.empty()) {
+        delete clip;
+        return false;
+    }
+    engine_set_modulator(gEngine, clip);
+    return true;
+}
 
 // ------------------------------
 // Audio render thread
 // ------------------------------
 
+// Drain pending capture packets into the vocoder's modulator FIFO
+static void PollCapture(float sampleRate) {
+    if (!gWASAPI.pCap) return;
+    const int    channels = int(gWASAPI.pCapFmt->nChannels);
+    const double step = double(gWASAPI.pCapFmt->nSamplesPerSec) / sampleRate;
+
+    UINT32 packet = 0;
+    while (SUCCEEDED(gWASAPI.pCap->GetNextPacketSize(&packet)) && packet > 0) {
+        BYTE* pData = nullptr;
+        UINT32 frames = 0;
+        DWORD flags = 0;
+        if (FAILED(gWASAPI.pCap->GetBuffer(&pData, &frames, &flags, nullptr, nullptr))) break;
+        const float* in = (flags & AUDCLNT_BUFFERFLAGS_SILENT) ? nullptr : reinterpret_cast<const float*>(pData);
+        modulator_push(gSynth.mod, in, frames, channels, step);
+        gWASAPI.pCap->ReleaseBuffer(frames);
+    }
+}
+
 DWORD WINAPI AudioThreadMain(LPVOID) {
+    log_thread_name(gLog, "audio");
+
     // Boost thread priority for audio
     DWORD taskIdx = 0;
     gWASAPI.hAvrt = AvSetMmThreadCharacteristicsW(L"Pro Audio", &taskIdx);
+    if (!gWASAPI.hAvrt) log_event(gLog, LogLevel::Warn, "audio: no Pro Audio scheduling (error %u)", uint32_t(GetLastError()));
+
+    // Flush denormals to zero; recursive filters decay into them otherwise
+    _mm_setcsr(_mm_getcsr() | 0x8040);
 
     gWASAPI.running.store(true);
     const float sampleRate = float(gWASAPI.pMixFmt->nSamplesPerSec);
     const int   channels = int(gWASAPI.pMixFmt->nChannels);
-    const float dt = 1.0f / sampleRate;
-
-    // Delay line for subtle stereo decorrelation
-    const size_t delaySamples = size_t(sampleRate * 0.012f); // 12 ms
-    gSynth.delayBufL.assign(delaySamples, 0.0f);
-    gSynth.delayBufR.assign(delaySamples, 0.0f);
-    gSynth.delayIndex = 0;
 
-    // Smooth coefficients (fast but safe)
-    const float hzSmoothCoeff = 0.05f;  // frequency slew
-    const float gainSmoothCoeff = 0.075f; // amplitude slew
+    engine_init(gEngine, sampleRate);
 
     // Start
+    const char* failed = nullptr; // the call that stopped the stream
+    UINT32 xruns = 0, xrunsLogged = 0;
+    double xrunAt = -1.0;         // last xrun report (< 0: none in the last second)
     HRESULT hr = gWASAPI.pCli->Start();
-    if (FAILED(hr)) goto done;
+    if (FAILED(hr)) { failed = "Start"; goto done; }
+    if (gWASAPI.pCapCli) gWASAPI.pCapCli->Start();
 
     while (gWASAPI.running.load()) {
         DWORD waitRes = WaitForSingleObject(gWASAPI.hEvent, 5 /*ms timeout*/);
@@ -162,137 +253,987 @@ DWORD WINAPI AudioThreadMain(LPVOID) {
 
         UINT32 padding = 0;
         hr = gWASAPI.pCli->GetCurrentPadding(&padding);
-        if (FAILED(hr)) break;
+        if (FAILED(hr)) { failed = "GetCurrentPadding"; break; }
+        // Nothing left queued: the device played out before this refill.
+        // The first xrun is logged at once, later ones as a count once a
+        // second, until a second passes without one.
+        if (padding == 0 || xrunAt >= 0.0) {
+            const double tick = NowSeconds();
+            if (padding == 0) ++xruns;
+            if (padding == 0 && xrunAt < 0.0) {
+                log_event(gLog, LogLevel::Warn, "audio: xrun, the device buffer ran dry (%u so far)", xruns);
+                xrunsLogged = xruns;
+                xrunAt = tick;
+            } else if (tick - xrunAt >= 1.0) {
+                if (xruns != xrunsLogged)
+                    log_event(gLog, LogLevel::Warn, "audio: %u more xruns in %.1f s", xruns - xrunsLogged, tick - xrunAt);
+                xrunAt = xruns != xrunsLogged ? tick : -1.0;
+                xrunsLogged = xruns;
+            }
+        }
 
         UINT32 framesToWrite = gWASAPI.bufferFrames - padding;
         if (framesToWrite == 0) continue;
 
         BYTE* pData = nullptr;
         hr = gWASAPI.pRen->GetBuffer(framesToWrite, &pData);
-        if (FAILED(hr) || !pData) break;
+        if (FAILED(hr) || !pData) { failed = "GetBuffer"; break; }
 
         float* out = reinterpret_cast<float*>(pData);
 
-        for (UINT32 i = 0; i < framesToWrite; ++i) {
-            // Read targets
-            float tgtHz = gParams.targetHz.load();
-            float tgtGain = gParams.targetGain.load();
-            bool  mute = gParams.mute.load();
-            int   mode = gParams.mode.load();
-            float vibAmt = gParams.vibratoDepth.load();
-
-            // Smooth
-            gSynth.smoothHz = smooth_step(gSynth.smoothHz, tgtHz, hzSmoothCoeff);
-            gSynth.smoothGain = smooth_step(gSynth.smoothGain, tgtGain, gainSmoothCoeff);
-
-            // Vibrato (5.5 Hz)
-            gSynth.vibratoPhase += kTwoPi * 5.5f * dt;
-            if (gSynth.vibratoPhase >= kTwoPi) gSynth.vibratoPhase -= kTwoPi;
-            float vibrato = (vibAmt > 0.0f) ? 0.01f * vibAmt * sinf(gSynth.vibratoPhase) : 0.0f;
-
-            float hz = gSynth.smoothHz * (1.0f + vibrato);
-            float incA = kTwoPi * hz * dt;
-            float incB = kTwoPi * (hz * 1.997f) * dt; // mod osc ~2x main
-
-            // Advance phases
-            gSynth.phaseA += incA;
-            if (gSynth.phaseA >= kTwoPi) gSynth.phaseA -= kTwoPi;
-            gSynth.phaseB += incB;
-            if (gSynth.phaseB >= kTwoPi) gSynth.phaseB -= kTwoPi;
-
-            // Base tones
-            float aSine = sine(gSynth.phaseA);
-            float bSine = sine(gSynth.phaseB);
-            float sample = 0.0f;
-
-            switch (mode) {
-            case 1: { // pure sine
-                sample = aSine;
-            } break;
-            case 2: { // sine + ring modulation
-                float ring = aSine * bSine;         // sidebands
-                sample = 0.70f * aSine + 0.45f * ring;
-            } break;
-            case 3: { // airy: sine + noise + gentle saturation
-                float n = 0.25f * white_noise();
-                float pre = 0.85f * aSine + n;
-                sample = fast_tanhf(pre);           // soft saturation
-            } break;
-            case 4: { // soft saw/tri hybrid
-                float s = soft_saw(gSynth.phaseA);
-                float t = soft_tri(gSynth.phaseA);
-                sample = 0.6f * s + 0.4f * t;
-            } break;
-            default: sample = aSine; break;
-            }
+        PollCapture(sampleRate);
+        engine_drain(gEngine, sampleRate);
+
+        // Taps: the loudness meter, and stem takes when one is recording
+        const bool stems = gRecorder.recording.load() && gRecorder.mode.load() != int(RecordMode::Master);
+        gEngine.analysisTap = gAnalysis.running.load(std::memory_order_relaxed) ? &gAnalysis.tap : nullptr;
+        gEngine.stemTap = stems ? &gRecorder.tap : nullptr;
+        gEngine.stemTake = float(gRecorder.take.load());
+
+        // Queued frames play first, then the stream latency
+        const double now = NowSeconds();
+        for (UINT32 written = 0; written < framesToWrite; ) {
+            UINT32 n = std::min(kBlockFrames, framesToWrite - written);
+            gSynth.renderTime = now;
+            gSynth.playTime = now + double(padding + written) / sampleRate + gWASAPI.streamLatency;
+            engine_render(gEngine, out + size_t(written) * channels, n, channels, sampleRate);
+            written += n;
+        }
 
-            // Apply amplitude and mute
-            float gain = mute ? 0.0f : gSynth.smoothGain;
-            float dryL = sample * gain;
-            float dryR = sample * gain;
-
-            // Minimal stereo decorrelation via short delay & crossfeed
-            size_t di = gSynth.delayIndex;
-            float dL = gSynth.delayBufL[di];
-            float dR = gSynth.delayBufR[di];
-            gSynth.delayBufL[di] = 0.85f * dL + 0.15f * dryL;
-            gSynth.delayBufR[di] = 0.85f * dR + 0.15f * dryR;
-            gSynth.delayIndex = (di + 1) % gSynth.delayBufL.size();
-
-            float outL = 0.85f * dryL + 0.15f * dR;
-            float outR = 0.85f * dryR + 0.15f * dL;
-
-            // Write interleaved stereo float
-            out[i * channels + 0] = outL;
-            if (channels > 1) out[i * channels + 1] = outR;
+        // Master take: the device buffer as one record
+        if (gRecorder.recording.load() && gRecorder.mode.load() == int(RecordMode::Master)) {
+            const UINT32 n = framesToWrite * UINT32(channels);
+            if (spsc_reserve(gRecorder.tap, kRecordHeader + n)) {
+                spsc_at(gRecorder.tap, 0) = float(gRecorder.take.load());
+                spsc_at(gRecorder.tap, 1) = float(n);
+                spsc_put(gRecorder.tap, kRecordHeader, out, n);
+                spsc_commit(gRecorder.tap, kRecordHeader + n);
+            }
         }
 
         hr = gWASAPI.pRen->ReleaseBuffer(framesToWrite, 0);
-        if (FAILED(hr)) break;
+        if (FAILED(hr)) { failed = "ReleaseBuffer"; break; }
     }
 
 done:
+    if (failed) log_event(gLog, LogLevel::Error, "audio: %s failed (hr 0x%08x), the stream stopped", failed, uint32_t(hr));
+    epoch_leave(gEngine.reclaim, kEpochRender);
     if (gWASAPI.pCli) gWASAPI.pCli->Stop();
+    if (gWASAPI.pCapCli) gWASAPI.pCapCli->Stop();
     if (gWASAPI.hAvrt) { AvRevertMmThreadCharacteristics(gWASAPI.hAvrt); gWASAPI.hAvrt = nullptr; }
     return 0;
 }
 
+// ------------------------------
+// Analysis thread (loudness)
+// ------------------------------
+
+static HANDLE OpenLoudnessLog(const wchar_t* path) {
+    HANDLE h = CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return nullptr;
+    const char header[] = "seconds,momentary_lufs,short_term_lufs,integrated_lufs,true_peak_dbtp\n";
+    DWORD wrote = 0;
+    WriteFile(h, header, DWORD(sizeof(header) - 1), &wrote, nullptr);
+    return h;
+}
+
+DWORD WINAPI AnalysisThreadMain(LPVOID) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+
+    LoudnessMeter& m = gAnalysis.meter;
+    LoudnessReadout& out = gAnalysis.readout;
+    loudness_init(m, gAnalysis.sampleRate);
+    HANDLE log = gOptions.loudnessCsv.empty() ? nullptr : OpenLoudnessLog(gOptions.loudnessCsv.c_str());
+
+    static float chunk[4096];
+    uint64_t analysed = 0;
+    uint64_t nextExport = uint64_t(gAnalysis.sampleRate);
+    while (gAnalysis.running.load()) {
+        if (out.resetRequest.exchange(false)) loudness_reset(m);
+
+        const uint32_t n = spsc_read(gAnalysis.tap, chunk, 4096);
+        if (n == 0) { Sleep(10); continue; }
+        loudness_process(m, chunk, n / 2);
+        analysed += n / 2;
+
+        out.momentary.store(m.momentary);
+        out.shortTerm.store(m.shortTerm);
+        out.integrated.store(m.integrated);
+        out.truePeakDb.store(loudness_true_peak_db(m));
+
+        if (log && analysed >= nextExport) {
+            char line[128];
+            const int len = snprintf(line, sizeof(line), "%.1f,%.2f,%.2f,%.2f,%.2f\n",
+                double(analysed) / gAnalysis.sampleRate, m.momentary, m.shortTerm, m.integrated,
+                loudness_true_peak_db(m));
+            DWORD wrote = 0;
+            WriteFile(log, line, DWORD(len), &wrote, nullptr);
+            nextExport += uint64_t(gAnalysis.sampleRate);
+        }
+    }
+    if (log) CloseHandle(log);
+    return 0;
+}
+
+// ------------------------------
+// Recorder thread
+// ------------------------------
+
+// Files of one take
+struct Take {
+    UnbufferedWriter file[kStemFileCount];
+    int              first[kStemFileCount];    // stem channel of the file's first channel
+    int              channels[kStemFileCount];
+    int              count = 0;
+    RecordMode       mode = RecordMode::Master;
+};
+
+// First take number with no theremin_takeNNN*.wav in the working directory
+static int NextTakeNumber() {
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    for (int n = 1; n < 999; ++n) {
+        wchar_t a[64], b[64], c[64];
+        swprintf(a, 64, L"theremin_take%03d.wav", n);
+        swprintf(b, 64, L"theremin_take%03d_stems.wav", n);
+        swprintf(c, 64, L"theremin_take%03d_voice.wav", n);
+        if (!GetFileAttributesExW(a, GetFileExInfoStandard, &info) &&
+            !GetFileAttributesExW(b, GetFileExInfoStandard, &info) &&
+            !GetFileAttributesExW(c, GetFileExInfoStandard, &info)) return n;
+    }
+    return 999;
+}
+
+static void CloseTake(Take& t) {
+    static uint8_t header[kDiskSector];
+    for (int f = 0; f < t.count; ++f) {
+        wav_float_header(header, kDiskSector, t.channels[f], gRecorder.sampleRate, t.file[f].bytes - kDiskSector);
+        disk_writer_close(t.file[f], header, kDiskSector);
+    }
+    t.count = 0;
+}
+
+static bool OpenTake(Take& t, RecordMode mode) {
+    static uint8_t header[kDiskSector];
+    const int number = NextTakeNumber();
+    t.mode = mode;
+    t.count = 0;
+    const int files = mode == RecordMode::StemFiles ? kStemFileCount : 1;
+    for (int f = 0; f < files; ++f) {
+        wchar_t path[96];
+        if (mode == RecordMode::Master) {
+            swprintf(path, 96, L"theremin_take%03d.wav", number);
+            t.first[f] = 0;
+            t.channels[f] = gRecorder.channels;
+        } else if (mode == RecordMode::Stems) {
+            swprintf(path, 96, L"theremin_take%03d_stems.wav", number);
+            t.first[f] = 0;
+            t.channels[f] = kStemChannels;
+        } else {
+            swprintf(path, 96, L"theremin_take%03d_%ls.wav", number, kStemFiles[f].suffix);
+            t.first[f] = kStemFiles[f].first;
+            t.channels[f] = kStemFiles[f].channels;
+        }
+        if (!disk_writer_open(t.file[f], path)) { CloseTake(t); return false; }
+        ++t.count;
+        // Placeholder header; sizes are patched on close
+        wav_float_header(header, kDiskSector, t.channels[f], gRecorder.sampleRate, 0);
+        disk_writer_append(t.file[f], header, kDiskSector);
+    }
+    return true;
+}
+
+// Append one record's payload (or a piece of a master record)
+static void WriteRecord(Take& t, const float* payload, uint32_t n) {
+    if (t.mode == RecordMode::Master) {
+        disk_writer_append(t.file[0], payload, n * sizeof(float));
+        return;
+    }
+    // Stems: planar block -> interleaved frames for each file
+    static float frames[kStemChannels * kBlockFrames];
+    const uint32_t count = n / kStemChannels;
+    for (int f = 0; f < t.count; ++f) {
+        const int ch = t.channels[f];
+        for (uint32_t i = 0; i < count; ++i)
+            for (int c = 0; c < ch; ++c) frames[i * ch + c] = payload[(t.first[f] + c) * count + i];
+        disk_writer_append(t.file[f], frames, count * ch * sizeof(float));
+    }
+}
+
+DWORD WINAPI RecorderThreadMain(LPVOID) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+
+    static float payload[16384];
+    static Take take;
+    bool open = false;
+    int takeId = 0;
+
+    for (;;) {
+        const bool running = gRecorder.running.load();
+        const bool armed = running && gRecorder.armed.load();
+        if (armed && !open) {
+            const RecordMode mode = RecordMode(gRecorder.requestMode.load());
+            open = OpenTake(take, mode);
+            if (open) {
+                gRecorder.take.store(++takeId);
+                gRecorder.mode.store(int(mode));
+                gRecorder.recording.store(true);
+            } else {
+                gRecorder.armed.store(false);
+            }
+        }
+        if (!armed && open) gRecorder.recording.store(false); // drain, then close below
+
+        if (spsc_available(gRecorder.tap) >= kRecordHeader) {
+            float header[kRecordHeader];
+            spsc_read(gRecorder.tap, header, kRecordHeader);
+            const bool mine = open && int(header[0]) == takeId;
+            // Records are published whole, so the payload is already there
+            for (uint32_t left = uint32_t(header[1]); left > 0; ) {
+                const uint32_t n = spsc_read(gRecorder.tap, payload, std::min<uint32_t>(left, 16384));
+                if (mine) WriteRecord(take, payload, n);
+                left -= n;
+            }
+            continue;
+        }
+
+        if (open && !armed) { CloseTake(take); open = false; }
+        if (!running) break;
+        Sleep(5);
+    }
+    return 0;
+}
+
+// ------------------------------
+// Log writer thread
+// ------------------------------
+
+struct LogContext {
+    HANDLE            hThread = nullptr;
+    std::atomic<bool> running{ false };
+};
+static LogContext gLogWriter;
+
+// Formats what the other threads logged and appends it to the log file (and
+// the debugger output), about ten times a second
+DWORD WINAPI LogThreadMain(LPVOID) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+    log_thread_name(gLog, "log");
+    HANDLE hFile = CreateFileW(gOptions.logFile.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    const int64_t origin = log_now_ns();
+    std::vector<LogRecord> records;
+    std::vector<const char*> threads;
+    for (bool last = false; !last; ) {
+        last = !gLogWriter.running.load();
+        log_drain(gLog, records, threads);
+        for (size_t i = 0; i < records.size(); ++i) {
+            const std::string line = log_line(records[i], threads[i], origin);
+            OutputDebugStringA(line.c_str());
+            DWORD written = 0;
+            if (hFile != INVALID_HANDLE_VALUE) WriteFile(hFile, line.data(), DWORD(line.size()), &written, nullptr);
+        }
+        if (!last) Sleep(100);
+    }
+    if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+    return 0;
+}
+
+static void StartLog() {
+    gLogWriter.running.store(true);
+    gLogWriter.hThread = CreateThread(nullptr, 0, LogThreadMain, nullptr, 0, nullptr);
+    if (!gLogWriter.hThread) gLogWriter.running.store(false);
+}
+
+// Last thing before exit: writes out whatever is still queued
+static void StopLog() {
+    if (!gLogWriter.hThread) return;
+    gLogWriter.running.store(false);
+    WaitForSingleObject(gLogWriter.hThread, INFINITE);
+    CloseHandle(gLogWriter.hThread);
+    gLogWriter.hThread = nullptr;
+}
+
+// ------------------------------
+// Game controller polling thread
+// ------------------------------
+//
+// XInput has no change notification, so pads are polled at kInputPollHz
+// and each change goes into the control queue stamped with its poll time.
+// Left stick X glides the pitch (rate control, so letting go holds the
+// note). The right trigger is volume; right stick deflection is vibrato
+// depth. Empty slots are probed once a second only, because XInputGetState
+// on a disconnected slot is slow.
+
+struct InputContext {
+    HANDLE hThread = nullptr;
+    std::atomic<bool>     running{ false };
+    std::atomic<uint32_t> polls{ 0 };
+};
+static InputContext gInput;
+static constexpr int   kInputPollHz = 1000;
+static constexpr float kPadGlideRate = 0.5f; // pitch range per second at full deflection
+
+// Stick axis to -1..1 outside the dead zone
+static float PadAxis(SHORT v, SHORT deadzone) {
+    const float a = fabsf(float(v)), d = float(deadzone);
+    if (a <= d) return 0.0f;
+    return copysignf(std::min(1.0f, (a - d) / (32767.0f - d)), float(v));
+}
+
+DWORD WINAPI InputThreadMain(LPVOID) {
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+    // Sub-millisecond ticks need a high-resolution timer (Windows 10 1803+);
+    // otherwise raise the system timer resolution for the regular one
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    const bool coarse = !timer;
+    if (coarse) {
+        timeBeginPeriod(1);
+        timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+    if (!timer) return 0;
+    LARGE_INTEGER due;
+    due.QuadPart = -10000000LL / kInputPollHz; // relative, 100 ns units
+
+    bool  connected[XUSER_MAX_COUNT] = {};
+    DWORD packet[XUSER_MAX_COUNT] = {};
+    // Last trigger and right-stick values pushed per pad (0 = at rest): a
+    // pad only speaks when one of its own controls moves
+    int   trigger[XUSER_MAX_COUNT] = {}, depth[XUSER_MAX_COUNT] = {};
+    double lastScan = -1.0, lastPoll = NowSeconds();
+    while (gInput.running.load()) {
+        SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE);
+        WaitForSingleObject(timer, 100);
+        const double now = NowSeconds();
+        const bool scan = now - lastScan >= 1.0;
+        if (scan) lastScan = now;
+
+        for (DWORD i = 0; i < XUSER_MAX_COUNT; ++i) {
+            if (!connected[i] && !scan) continue;
+            XINPUT_STATE st{};
+            connected[i] = XInputGetState(i, &st) == ERROR_SUCCESS;
+            if (!connected[i]) continue;
+            const XINPUT_GAMEPAD& g = st.Gamepad;
+            ControlEvent e;
+            e.t = now;
+            e.source = ControlSource::Gamepad;
+            const float lx = PadAxis(g.sThumbLX, XINPUT_GAMEPAD_LEFT_THUMB_DEADZONE);
+            if (lx != 0.0f) {
+                e.type = ControlType::Motion;
+                e.x = lx * kPadGlideRate * float(now - lastPoll);
+                e.y = 0.0f;
+                control_push(gControl, e);
+            }
+            if (st.dwPacketNumber == packet[i]) continue; // nothing else changed
+            packet[i] = st.dwPacketNumber;
+            // Buttons change the packet too, so each value is compared with
+            // what was last pushed (a dropped push is retried next poll)
+            const int t = std::max(0, int(g.bRightTrigger) - XINPUT_GAMEPAD_TRIGGER_THRESHOLD);
+            if (t != trigger[i]) {
+                e.type = ControlType::Gain;
+                e.x = t / float(255 - XINPUT_GAMEPAD_TRIGGER_THRESHOLD);
+                if (control_push(gControl, e)) trigger[i] = t;
+                else packet[i] = 0;
+            }
+            const float rx = PadAxis(g.sThumbRX, XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE);
+            const float ry = PadAxis(g.sThumbRY, XINPUT_GAMEPAD_RIGHT_THUMB_DEADZONE);
+            const int d = int(std::min(1.0f, sqrtf(rx * rx + ry * ry)) * 100.0f + 0.5f); // 1% steps
+            if (d != depth[i]) {
+                e.type = ControlType::Vibrato;
+                e.x = d / 100.0f;
+                if (control_push(gControl, e)) depth[i] = d;
+                else packet[i] = 0;
+            }
+        }
+        lastPoll = now;
+        gInput.polls.fetch_add(1, std::memory_order_relaxed);
+    }
+    CloseHandle(timer);
+    if (coarse) timeEndPeriod(1);
+    return 0;
+}
+
+static void StartInput() {
+    gInput.running.store(true);
+    gInput.hThread = CreateThread(nullptr, 0, InputThreadMain, nullptr, 0, nullptr);
+}
+
+static void StopInput() {
+    gInput.running.store(false);
+    if (gInput.hThread) {
+        WaitForSingleObject(gInput.hThread, 1000);
+        CloseHandle(gInput.hThread);
+        gInput.hThread = nullptr;
+    }
+}
+
+// ------------------------------
+// Config file: watched and parsed on its own thread, applied on the UI thread
+// ------------------------------
+//
+// The watcher reads the whole file again on every change and posts the
+// parsed result; a file that fails to parse is ignored and the last good
+// settings stay. The UI thread hands the playing-surface settings to the
+// engine as one pointer swap and reopens the device in the background when
+// the latency changes.
+
+static constexpr UINT WM_APP_CONFIG = WM_APP + 2;   // lParam: AppConfig*, the UI thread frees it
+static constexpr UINT WM_APP_REOPENED = WM_APP + 3; // wParam: the device came back
+
+struct ConfigContext {
+    AppConfig app;                 // UI thread: what is applied now
+    HANDLE    hThread = nullptr;   // watcher
+    HANDLE    hStop = nullptr;     // event: stop watching
+    HANDLE    hReopen = nullptr;   // device reopen in progress
+    bool      reopenAgain = false; // latency changed again meanwhile
+};
+static ConfigContext gConfig;
+
+// WASAPI setup/teardown, below
+static bool OpenAudio();
+static void CloseAudio();
+
+// Null if the file is missing or does not parse. Retries briefly, since an
+// editor may still hold the file open for writing when the change arrives.
+static AppConfig* ReadConfigFile(const wchar_t* path) {
+    if (GetFileAttributesW(path) == INVALID_FILE_ATTRIBUTES) return nullptr;
+    std::vector<uint8_t> bytes;
+    bool read = false;
+    for (int tries = 0; tries < 5 && !(read = ReadWholeFile(path, bytes)); ++tries) Sleep(20);
+    if (!read) return nullptr;
+    AppConfig* c = new AppConfig();
+    int line = 0;
+    if (!config_parse(reinterpret_cast<const char*>(bytes.data()), bytes.size(), *c, &line)) {
+        if (line > 0) log_event(gLog, LogLevel::Warn, "config: line %d not understood, keeping the current settings", line);
+        else log_event(gLog, LogLevel::Warn, "config: pitch range too narrow, keeping the current settings");
+        delete c;
+        return nullptr;
+    }
+    return c;
+}
+
+DWORD WINAPI ConfigThreadMain(LPVOID) {
+    log_thread_name(gLog, "config");
+    // Watch the directory and pick out the file's own changes
+    const std::wstring& path = gOptions.configFile;
+    const size_t slash = path.find_last_of(L"\\/");
+    const std::wstring dir = slash == std::wstring::npos ? L"." : path.substr(0, slash);
+    const std::wstring name = slash == std::wstring::npos ? path : path.substr(slash + 1);
+    HANDLE hDir = CreateFileW(dir.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (hDir == INVALID_HANDLE_VALUE) return 0;
+
+    OVERLAPPED ov{};
+    ov.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    alignas(DWORD) BYTE buf[4096];
+    const HANDLE waits[2] = { gConfig.hStop, ov.hEvent };
+    for (;;) {
+        ResetEvent(ov.hEvent);
+        if (!ReadDirectoryChangesW(hDir, buf, sizeof(buf), FALSE,
+                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &ov, nullptr)) break;
+        DWORD got = 0;
+        if (WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+            CancelIoEx(hDir, &ov);
+            GetOverlappedResult(hDir, &ov, &got, TRUE);
+            break;
+        }
+        if (!GetOverlappedResult(hDir, &ov, &got, FALSE)) break;
+
+        bool changed = got == 0; // the list overflowed: check anyway
+        for (DWORD at = 0; !changed && at < got; ) {
+            const FILE_NOTIFY_INFORMATION* n = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buf + at);
+            changed = CompareStringOrdinal(n->FileName, int(n->FileNameLength / sizeof(WCHAR)),
+                name.c_str(), int(name.size()), TRUE) == CSTR_EQUAL;
+            if (!n->NextEntryOffset) break;
+            at += n->NextEntryOffset;
+        }
+        if (!changed) continue;
+        Sleep(50); // saves often arrive as several writes
+        AppConfig* c = ReadConfigFile(path.c_str());
+        if (c && !PostMessageW(gHWND, WM_APP_CONFIG, 0, LPARAM(c))) delete c;
+    }
+    CloseHandle(ov.hEvent);
+    CloseHandle(hDir);
+    return 0;
+}
+
+// Close and open the device on a worker, so the window keeps responding
+DWORD WINAPI ReopenThreadMain(LPVOID) {
+    const HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    CloseAudio();
+    if (FAILED(hr)) log_event(gLog, LogLevel::Error, "audio: reopen: CoInitializeEx failed (hr 0x%08x)", uint32_t(hr));
+    const bool ok = SUCCEEDED(hr) && OpenAudio();
+    if (SUCCEEDED(hr)) CoUninitialize();
+    PostMessageW(gHWND, WM_APP_REOPENED, ok, 0);
+    return 0;
+}
+
+// UI thread. The audio objects belong to the reopen thread until it posts
+// WM_APP_REOPENED; a request meanwhile runs once it is done.
+static void ReopenAudio() {
+    if (gConfig.hReopen) { gConfig.reopenAgain = true; return; }
+    gWASAPI.bufferMs = gConfig.app.latencyMs;
+    gConfig.hReopen = CreateThread(nullptr, 0, ReopenThreadMain, nullptr, 0, nullptr);
+}
+
+// The engine side of a config: mapping, slews and the EQ bands
+static void SetEngineConfig(const AppConfig& c) {
+    engine_set_config(gEngine, c.engine);
+    for (int k = 0; k < kEqBands; ++k) eq_set_band(gParams.eq, k, c.eq[k]);
+    eq_commit(gParams.eq);
+}
+
+// UI thread: take over a parsed config
+static void ApplyConfig(const AppConfig& c) {
+    const bool reopen = c.latencyMs != gConfig.app.latencyMs;
+    gConfig.app = c;
+    SetEngineConfig(c);
+    log_event(gLog, LogLevel::Info, "config: applied (%.0f-%.0f Hz, %.0f ms)", double(c.engine.minHz), double(c.engine.maxHz), double(c.latencyMs));
+    if (reopen) ReopenAudio();
+}
+
+// At startup, before the device opens: the file as it is, then the watcher
+static void StartConfig() {
+    config_defaults(gConfig.app);
+    if (AppConfig* c = ReadConfigFile(gOptions.configFile.c_str())) {
+        gConfig.app = *c;
+        SetEngineConfig(*c);
+        delete c;
+    }
+    gWASAPI.bufferMs = gConfig.app.latencyMs;
+    gConfig.hStop = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    gConfig.hThread = CreateThread(nullptr, 0, ConfigThreadMain, nullptr, 0, nullptr);
+}
+
+static void StopConfig() {
+    if (gConfig.hThread) {
+        SetEvent(gConfig.hStop);
+        WaitForSingleObject(gConfig.hThread, 1000);
+        CloseHandle(gConfig.hThread);
+        gConfig.hThread = nullptr;
+    }
+    if (gConfig.hStop) { CloseHandle(gConfig.hStop); gConfig.hStop = nullptr; }
+    if (gConfig.hReopen) { // let a reopen finish before the device is shut down
+        WaitForSingleObject(gConfig.hReopen, INFINITE);
+        CloseHandle(gConfig.hReopen);
+        gConfig.hReopen = nullptr;
+    }
+}
+
 // ------------------------------
 // Win32 window and input
 // ------------------------------
 
+static const wchar_t* const kRecordModeNames[] = { L"master", L"stems", L"stem files" };
+
+// Raw mouse input (I): relative device counts instead of cursor positions.
+// Absolute devices (tablets, remote desktop) keep using WM_MOUSEMOVE.
+static bool gRawInput = false;
+static constexpr float kRawCountScale = 1.0f; // device counts per client pixel
+static constexpr UINT32 kPenHistory = 64;     // pen samples read per pointer message
+static float gMouseVibrato = 0.0f;            // Shift depth last pushed for the mouse
+
+static void SetRawInput(HWND hWnd, bool on) {
+    RAWINPUTDEVICE rid{};
+    rid.usUsagePage = 0x01; // generic desktop
+    rid.usUsage = 0x02;     // mouse
+    rid.dwFlags = on ? 0 : RIDEV_REMOVE;
+    rid.hwndTarget = on ? hWnd : nullptr;
+    if (RegisterRawInputDevices(&rid, 1, sizeof(rid))) gRawInput = on;
+}
+
+// ------------------------------
+// Visuals: software canvas, one frame per display refresh
+// ------------------------------
+//
+// A pacing thread wakes on each composition pass (DwmFlush) and posts one
+// frame message; a frame still in the queue is never doubled up. The frame
+// reads engine state through the same atomics as everything else, redraws
+// only what moved into the canvas, and blits just those rectangles.
+
+static constexpr UINT WM_APP_FRAME = WM_APP + 1;
+static constexpr LONG kTextHeight = 44;   // two text lines across the top
+static constexpr LONG kMarkerSize = 9;
+static constexpr uint32_t kColorBack = 0x101418;
+static constexpr uint32_t kColorOctave = 0x3a4250;
+static constexpr uint32_t kColorSemitone = 0x1c222a;
+static constexpr uint32_t kColorMarker = 0xffc040;
+static constexpr uint32_t kColorMuted = 0x707070;
+static constexpr uint32_t kColorLevel = 0x40c070;
+static constexpr uint32_t kColorLevelHot = 0xe04040; // true peak above -1 dBTP
+
+struct UiContext {
+    Canvas       canvas;
+    DirtyRects   dirty;
+    FrameStats   stats;
+    RECT         marker{}, level{};     // as last drawn
+    std::wstring text[2];
+    double       textTime = 0.0;
+    double       refreshPeriod = 1.0 / 60.0;
+    uint32_t     polls = 0;                 // controller polls at the last readout
+    double       pollTime = 0.0;
+    HANDLE       hPacer = nullptr;
+    std::atomic<bool> running{ false };
+    std::atomic<bool> framePending{ false };
+};
+static UiContext gUi;
+
+static RECT MarkerRect() {
+    const Canvas& c = gUi.canvas;
+    const float nx = map_hz_to_nx(gConfig.app.engine, gParams.targetHz.load());
+    const float ny = 1.0f - gParams.targetGain.load();
+    const LONG x = LONG(nx * c.w), y = LONG(ny * c.h);
+    return RECT{ x - kMarkerSize / 2, y - kMarkerSize / 2, x + kMarkerSize / 2 + 1, y + kMarkerSize / 2 + 1 };
+}
+
+// Momentary loudness, -60..0 LUFS, up the right edge
+static RECT LevelRect(float lufs) {
+    const Canvas& c = gUi.canvas;
+    const float k = std::max(0.0f, std::min(1.0f, (lufs + 60.0f) / 60.0f));
+    const LONG top = kTextHeight + 8, bottom = c.h - 8;
+    return RECT{ c.w - 18, bottom - LONG(k * float(std::max<LONG>(bottom - top, 0))), c.w - 8, bottom };
+}
+
+// Returns true when either line changed
+static bool UpdateText() {
+    const LoudnessReadout& m = gAnalysis.readout;
+    FrameStats& f = gUi.stats;
+    wchar_t line[2][192];
+    wchar_t comp[32] = L"";
+    if (gParams.dyn.enabled.load()) swprintf(comp, 32, L"   GR %5.1f dB", gParams.dyn.gainReductionDb.load());
+    swprintf(line[0], 192, L"M %6.1f   S %6.1f   I %6.1f LUFS   TP %6.1f dBTP   (L resets)%ls%ls   T: %ls%ls",
+        m.momentary.load(), m.shortTerm.load(), m.integrated.load(), m.truePeakDb.load(), comp,
+        gRecorder.recording.load() ? L"   REC" : L"",
+        kRecordModeNames[gRecorder.requestMode.load()],
+        gRawInput ? L"   RAW" : L"");
+    const uint32_t polls = gInput.polls.load();
+    const double now = NowSeconds();
+    const double pollHz = (polls - gUi.polls) / std::max(1e-3, now - gUi.pollTime);
+    gUi.polls = polls;
+    gUi.pollTime = now;
+    swprintf(line[1], 192, L"frame %5.1f ms (worst %5.1f, %u late)   draw %5.0f us   display %4.0f Hz   input dropped %u merged %u   pad poll %4.0f Hz",
+        f.intervalMs, f.worstMs, f.late, f.drawUs, 1.0 / gUi.refreshPeriod, gControl.dropped.load(), gControl.coalesced.load(), pollHz);
+    f.worstMs = 0.0f;
+    bool changed = false;
+    for (int i = 0; i < 2; ++i) {
+        if (gUi.text[i] != line[i]) { gUi.text[i] = line[i]; changed = true; }
+    }
+    return changed;
+}
+
+// Repaint everything that intersects `area` into the canvas
+static void DrawScene(const RECT& area) {
+    Canvas& c = gUi.canvas;
+    const RECT r = canvas_clip(c, area);
+    if (rect_empty(r)) return;
+    canvas_fill(c, r, kColorBack);
+
+    // Pitch grid: every semitone of A from 27.5 Hz, octaves brighter
+    const EngineConfig& cfg = gConfig.app.engine;
+    for (int k = 0; ; ++k) {
+        const float hz = 27.5f * powf(2.0f, k / 12.0f);
+        if (hz > cfg.maxHz) break;
+        if (hz < cfg.minHz) continue;
+        const LONG x = LONG(map_hz_to_nx(cfg, hz) * c.w);
+        canvas_fill(c, rect_intersect(RECT{ x, kTextHeight, x + 1, c.h }, r), k % 12 ? kColorSemitone : kColorOctave);
+    }
+
+    if (r.top < kTextHeight) {
+        IntersectClipRect(c.dc, r.left, r.top, r.right, r.bottom);
+        SetBkMode(c.dc, TRANSPARENT);
+        SetTextColor(c.dc, RGB(200, 205, 215));
+        for (int i = 0; i < 2; ++i)
+            TextOutW(c.dc, 8, 6 + 18 * i, gUi.text[i].c_str(), int(gUi.text[i].size()));
+        SelectClipRgn(c.dc, nullptr);
+        GdiFlush(); // text must land before the fills below
+    }
+
+    const bool hot = gAnalysis.readout.truePeakDb.load() > -1.0f;
+    canvas_fill(c, rect_intersect(gUi.level, r), hot ? kColorLevelHot : kColorLevel);
+    canvas_fill(c, rect_intersect(gUi.marker, r), gParams.mute.load() ? kColorMuted : kColorMarker);
+}
+
+static void ResizeCanvas(HWND hWnd) {
+    RECT rc{}; GetClientRect(hWnd, &rc);
+    HDC dc = GetDC(hWnd);
+    canvas_resize(gUi.canvas, dc, rc.right - rc.left, rc.bottom - rc.top);
+    ReleaseDC(hWnd, dc);
+    gUi.marker = MarkerRect();
+    gUi.level = LevelRect(gAnalysis.readout.momentary.load());
+    gUi.dirty.n = 0;
+    DrawScene(RECT{ 0, 0, gUi.canvas.w, gUi.canvas.h });
+}
+
+static void DrawFrame(HWND hWnd) {
+    Canvas& c = gUi.canvas;
+    if (!c.px) return;
+    const double start = NowSeconds();
+
+    const RECT marker = MarkerRect();
+    if (!rect_equal(marker, gUi.marker)) {
+        dirty_add(gUi.dirty, gUi.marker);
+        dirty_add(gUi.dirty, marker);
+        gUi.marker = marker;
+    }
+    const RECT level = LevelRect(gAnalysis.readout.momentary.load());
+    if (!rect_equal(level, gUi.level)) {
+        dirty_add(gUi.dirty, rect_union(level, gUi.level));
+        gUi.level = level;
+    }
+    if (start - gUi.textTime >= 0.2) {
+        if (UpdateText()) dirty_add(gUi.dirty, RECT{ 0, 0, c.w, kTextHeight });
+        gUi.textTime = start;
+    }
+
+    if (gUi.dirty.n) {
+        for (int i = 0; i < gUi.dirty.n; ++i) DrawScene(gUi.dirty.r[i]);
+        HDC dc = GetDC(hWnd);
+        for (int i = 0; i < gUi.dirty.n; ++i) canvas_blit(c, dc, gUi.dirty.r[i]);
+        ReleaseDC(hWnd, dc);
+        gUi.dirty.n = 0;
+    }
+    frame_stats_update(gUi.stats, start, NowSeconds(), gUi.refreshPeriod);
+}
+
+DWORD WINAPI PacerThreadMain(LPVOID) {
+    while (gUi.running.load()) {
+        // Returns after the next composition pass; without DWM, sleep a period
+        if (FAILED(DwmFlush())) Sleep(DWORD(gUi.refreshPeriod * 1000.0));
+        if (!gUi.framePending.exchange(true)) PostMessageW(gHWND, WM_APP_FRAME, 0, 0);
+    }
+    return 0;
+}
+
+static void InitVisuals() {
+    DWM_TIMING_INFO ti{};
+    ti.cbSize = sizeof(ti);
+    LARGE_INTEGER freq{};
+    QueryPerformanceFrequency(&freq);
+    if (SUCCEEDED(DwmGetCompositionTimingInfo(nullptr, &ti)) && ti.qpcRefreshPeriod)
+        gUi.refreshPeriod = double(ti.qpcRefreshPeriod) / double(freq.QuadPart);
+    gUi.running.store(true);
+    gUi.hPacer = CreateThread(nullptr, 0, PacerThreadMain, nullptr, 0, nullptr);
+}
+
+static void ShutdownVisuals() {
+    gUi.running.store(false);
+    if (gUi.hPacer) {
+        WaitForSingleObject(gUi.hPacer, 1000);
+        CloseHandle(gUi.hPacer);
+        gUi.hPacer = nullptr;
+    }
+    canvas_release(gUi.canvas);
+}
+
 LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
     case WM_DESTROY:
         gWASAPI.running.store(false);
         PostQuitMessage(0);
         return 0;
+    case WM_APP_FRAME:
+        if (!IsIconic(hWnd)) DrawFrame(hWnd);
+        gUi.framePending.store(false);
+        engine_reclaim(gEngine); // objects the audio thread has moved past
+        return 0;
+    case WM_APP_CONFIG: {
+        AppConfig* c = reinterpret_cast<AppConfig*>(lParam);
+        ApplyConfig(*c);
+        delete c;
+        ResizeCanvas(hWnd); // the pitch grid may have moved
+        InvalidateRect(hWnd, nullptr, FALSE);
+        return 0;
+    }
+    case WM_APP_REOPENED:
+        WaitForSingleObject(gConfig.hReopen, INFINITE);
+        CloseHandle(gConfig.hReopen);
+        gConfig.hReopen = nullptr;
+        if (gConfig.reopenAgain) {
+            gConfig.reopenAgain = false;
+            ReopenAudio();
+        } else if (!wParam) {
+            MessageBoxW(hWnd, L"Failed to reopen the audio device with the new latency.", L"Error", MB_OK | MB_ICONERROR);
+        }
+        return 0;
+    case WM_DROPFILES: { // a WAV dropped on the window becomes the vocoder modulator
+        HDROP drop = HDROP(wParam);
+        wchar_t path[MAX_PATH];
+        if (!gConfig.hReopen && gWASAPI.pMixFmt && DragQueryFileW(drop, 0, path, MAX_PATH))
+            LoadModulatorFile(path, float(gWASAPI.pMixFmt->nSamplesPerSec));
+        DragFinish(drop);
+        return 0;
+    }
+    case WM_SIZE:
+        ResizeCanvas(hWnd);
+        InvalidateRect(hWnd, nullptr, FALSE);
+        return 0;
+    case WM_ERASEBKGND:
+        return 1; // the canvas covers the whole client area
+    case WM_PAINT: {
+        PAINTSTRUCT ps;
+        HDC hdc = BeginPaint(hWnd, &ps);
+        canvas_blit(gUi.canvas, hdc, ps.rcPaint);
+        EndPaint(hWnd, &ps);
+        return 0;
+    }
     case WM_MOUSEMOVE: {
-        int x = GET_X_LPARAM(lParam);
-        int y = GET_Y_LPARAM(lParam);
+        // With raw input on, position comes from WM_INPUT instead
+        if (!gRawInput) {
+            RECT rc{}; GetClientRect(hWnd, &rc);
+            ControlEvent e;
+            e.t = NowSeconds();
+            e.x = GET_X_LPARAM(lParam) / float(std::max<LONG>(rc.right - rc.left, 1));
+            e.y = GET_Y_LPARAM(lParam) / float(std::max<LONG>(rc.bottom - rc.top, 1));
+            e.type = ControlType::Position;
+            e.source = ControlSource::Mouse;
+            control_push(gControl, e);
+        }
+        // Shift increases vibrato depth; pushed only when it changes
+        const float depth = (GetKeyState(VK_SHIFT) & 0x8000) ? 1.0f : 0.0f;
+        if (depth != gMouseVibrato) {
+            ControlEvent v;
+            v.t = NowSeconds();
+            v.x = depth;
+            v.type = ControlType::Vibrato;
+            v.source = ControlSource::Mouse;
+            if (control_push(gControl, v)) gMouseVibrato = depth; // a dropped one is retried on the next move
+        }
+        return 0;
+    }
+    case WM_POINTERDOWN:
+    case WM_POINTERUPDATE:
+    case WM_POINTERUP: {
+        // Pen: every sample coalesced into this message, oldest first, with
+        // its own timestamp. Pressure (1024 steps) is volume; hovering is
+        // silent. Other pointer types fall through to the mouse messages.
+        const UINT32 id = GET_POINTERID_WPARAM(wParam);
+        POINTER_INPUT_TYPE type = PT_POINTER;
+        if (!GetPointerType(id, &type) || type != PT_PEN) break;
+        POINTER_PEN_INFO pen[kPenHistory];
+        UINT32 count = kPenHistory;
+        if (!GetPointerPenInfoHistory(id, &count, pen)) return 0;
+        count = std::min(count, kPenHistory);
         RECT rc{}; GetClientRect(hWnd, &rc);
-        float hz = map_x_to_hz(x, rc.right - rc.left);
-        float gain = map_y_to_gain(y, rc.bottom - rc.top);
-        gParams.targetHz.store(hz);
-        gParams.targetGain.store(gain);
-        // Shift increases vibrato depth
-        bool shift = (GetKeyState(VK_SHIFT) & 0x8000) != 0;
-        gParams.vibratoDepth.store(shift ? 1.0f : 0.0f);
+        for (UINT32 i = count; i-- > 0; ) {
+            const POINTER_INFO& pi = pen[i].pointerInfo;
+            POINT pt = pi.ptPixelLocation;
+            ScreenToClient(hWnd, &pt);
+            const bool contact = (pi.pointerFlags & POINTER_FLAG_INCONTACT) != 0;
+            const float pressure = (pen[i].penMask & PEN_MASK_PRESSURE) ? pen[i].pressure / 1024.0f : 1.0f;
+            ControlEvent e;
+            e.t = pi.PerformanceCount ? QpcSeconds(LONGLONG(pi.PerformanceCount)) : NowSeconds();
+            e.x = pt.x / float(std::max<LONG>(rc.right - rc.left, 1));
+            e.y = 1.0f - (contact ? std::min(1.0f, pressure) : 0.0f);
+            e.type = ControlType::Position;
+            e.source = ControlSource::Pen;
+            control_push(gControl, e);
+        }
         return 0;
     }
-    case WM_KEYDOWN: {
-        switch (wParam) {
-        case '1': gParams.mode.store(1); break;
-        case '2': gParams.mode.store(2); break;
-        case '3': gParams.mode.store(3); break;
-        case '4': gParams.mode.store(4); break;
-        case VK_SPACE: {
+    case WM_INPUT: {
+        // Unaccelerated relative counts, one message per device report, so
+        // nothing is coalesced the way WM_MOUSEMOVE is
+        RAWINPUT ri;
+        UINT size = sizeof(ri);
+        if (gRawInput &&
+            GetRawInputData(reinterpret_cast<HRAWINPUT>(lParam), RID_INPUT, &ri, &size, sizeof(RAWINPUTHEADER)) != UINT(-1) &&
+            ri.header.dwType == RIM_TYPEMOUSE && !(ri.data.mouse.usFlags & MOUSE_MOVE_ABSOLUTE) &&
+            (ri.data.mouse.lLastX || ri.data.mouse.lLastY)) {
+            RECT rc{}; GetClientRect(hWnd, &rc);
+            ControlEvent e;
+            e.t = NowSeconds();
+            e.x = ri.data.mouse.lLastX * kRawCountScale / float(std::max<LONG>(rc.right - rc.left, 1));
+            e.y = ri.data.mouse.lLastY * kRawCountScale / float(std::max<LONG>(rc.bottom - rc.top, 1));
+            e.type = ControlType::Motion;
+            e.source = ControlSource::RawMouse;
+            control_push(gControl, e);
+        }
+        break; // DefWindowProc does the WM_INPUT cleanup
+    }
+    case WM_KEYDOWN: { // through the bindings (config key.*)
+        const KeyAction action = wParam < 256 ? gConfig.app.keys[wParam] : KeyAction::None;
+        switch (action) {
+        case KeyAction::Mode1: gParams.mode.store(1); break;
+        case KeyAction::Mode2: gParams.mode.store(2); break;
+        case KeyAction::Mode3: gParams.mode.store(3); break;
+        case KeyAction::Mode4: gParams.mode.store(4); break;
+        case KeyAction::Eq: {
+            bool b = gParams.eq.bypass.load();
+            gParams.eq.bypass.store(!b);
+        } break;
+        case KeyAction::Comp: {
+            bool c = gParams.dyn.enabled.load();
+            gParams.dyn.enabled.store(!c);
+        } break;
+        case KeyAction::Harmony: {
+            bool h = gParams.harm.enabled.load();
+            gParams.harm.enabled.store(!h);
+        } break;
+        case KeyAction::HarmonyHq: {
+            bool q = gParams.harm.highQuality.load();
+            gParams.harm.highQuality.store(!q);
+        } break;
+        case KeyAction::Vocoder: {
+            bool v = gParams.voc.enabled.load();
+            gParams.voc.enabled.store(!v);
+        } break;
+        case KeyAction::Delay: {
+            bool d = gParams.tape.enabled.load();
+            gParams.tape.enabled.store(!d);
+        } break;
+        case KeyAction::Adaptive: {
+            bool a = gParams.adaptiveSmoothing.load();
+            gParams.adaptiveSmoothing.store(!a);
+        } break;
+        case KeyAction::MasterUp:
+            gParams.gain.masterDb.store(std::min(kMasterMaxDb, gParams.gain.masterDb.load() + 1.0f));
+            break;
+        case KeyAction::MasterDown:
+            gParams.gain.masterDb.store(std::max(kMasterMinDb, gParams.gain.masterDb.load() - 1.0f));
+            break;
+        case KeyAction::AutoGain: {
+            bool g = gParams.gain.autoGain.load();
+            gParams.gain.autoGain.store(!g);
+        } break;
+        case KeyAction::ResetLoudness:
+            gAnalysis.readout.resetRequest.store(true);
+            break;
+        case KeyAction::Record: {
+            bool r = gRecorder.armed.load();
+            gRecorder.armed.store(!r);
+        } break;
+        case KeyAction::RecordMode: // next take: master, stems in one file, one file per stem
+            if (!gRecorder.armed.load()) gRecorder.requestMode.store((gRecorder.requestMode.load() + 1) % 3);
+            break;
+        case KeyAction::Chord: // chord, arpeggio, off
+            gParams.chord.mode.store((gParams.chord.mode.load() + 1) % 3);
+            break;
+        case KeyAction::Predict: {
+            bool p = gParams.predictGesture.load();
+            gParams.predictGesture.store(!p);
+        } break;
+        case KeyAction::RawInput:
+            SetRawInput(hWnd, !gRawInput);
+            break;
+        case KeyAction::Latch:      // latch the live voice as a drone
+        case KeyAction::Release:    // release the newest drone
+        case KeyAction::ReleaseAll: { // release all drones
+            ControlEvent e;
+            e.t = NowSeconds();
+            e.type = action == KeyAction::Latch ? ControlType::Latch : ControlType::Release;
+            e.x = action == KeyAction::ReleaseAll ? 1.0f : 0.0f;
+            e.source = ControlSource::Keyboard;
+            control_push(gControl, e);
+        } break;
+        case KeyAction::Mute: {
             bool m = gParams.mute.load();
             gParams.mute.store(!m);
         } break;
-        case VK_ESCAPE:
+        case KeyAction::Quit:
             DestroyWindow(hWnd);
             break;
+        default:
+            break;
         }
         return 0;
     }
@@ -314,60 +1255,110 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 // WASAPI setup/teardown
 // ------------------------------
 
-void ShutdownWASAPI() {
+// Stop the audio, analysis and recorder threads and release the device.
+// Safe to call twice; COM stays initialised.
+static void CloseAudio() {
     gWASAPI.running.store(false);
 
     if (gWASAPI.hAudioThread) {
         WaitForSingleObject(gWASAPI.hAudioThread, 2000);
         CloseHandle(gWASAPI.hAudioThread);
         gWASAPI.hAudioThread = nullptr;
+        engine_reclaim(gEngine);
+    }
+    gRecorder.armed.store(false);
+    gRecorder.running.store(false); // the thread drains and closes the take
+    if (gRecorder.hThread) {
+        WaitForSingleObject(gRecorder.hThread, 5000);
+        CloseHandle(gRecorder.hThread);
+        gRecorder.hThread = nullptr;
+    }
+    gAnalysis.running.store(false);
+    if (gAnalysis.hThread) {
+        WaitForSingleObject(gAnalysis.hThread, 2000);
+        CloseHandle(gAnalysis.hThread);
+        gAnalysis.hThread = nullptr;
     }
     if (gWASAPI.hEvent) {
         CloseHandle(gWASAPI.hEvent);
         gWASAPI.hEvent = nullptr;
     }
 
+    SafeRelease(&gWASAPI.pCap);
+    SafeRelease(&gWASAPI.pCapCli);
+    SafeRelease(&gWASAPI.pCapDev);
     SafeRelease(&gWASAPI.pRen);
     SafeRelease(&gWASAPI.pCli);
     SafeRelease(&gWASAPI.pDev);
     SafeRelease(&gWASAPI.pEnum);
 
+    if (gWASAPI.pCapFmt) {
+        CoTaskMemFree(gWASAPI.pCapFmt);
+        gWASAPI.pCapFmt = nullptr;
+    }
     if (gWASAPI.pMixFmt) {
         CoTaskMemFree(gWASAPI.pMixFmt);
         gWASAPI.pMixFmt = nullptr;
     }
+}
+
+void ShutdownWASAPI() {
+    CloseAudio();
     if (gWASAPI.coInit) {
         CoUninitialize();
         gWASAPI.coInit = false;
     }
 }
 
-// Replace your InitWASAPI with this:
-bool InitWASAPI(HWND) {
-    // COM init
-    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-    if (FAILED(hr)) return false;
-    gWASAPI.coInit = true;
+// Default capture endpoint for the vocoder's live modulator. Optional: on
+// failure the capture objects are released and the file stand-in is used.
+static bool InitCapture() {
+    HRESULT hr = gWASAPI.pEnum->GetDefaultAudioEndpoint(eCapture, eConsole, &gWASAPI.pCapDev);
+    if (SUCCEEDED(hr)) hr = gWASAPI.pCapDev->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&gWASAPI.pCapCli);
+    if (SUCCEEDED(hr)) hr = gWASAPI.pCapCli->GetMixFormat(&gWASAPI.pCapFmt);
+    const REFERENCE_TIME hnsBufferDuration = REFERENCE_TIME(gWASAPI.bufferMs * 10000.0f);
+    if (SUCCEEDED(hr)) hr = gWASAPI.pCapCli->Initialize(AUDCLNT_SHAREMODE_SHARED, 0, hnsBufferDuration, 0, gWASAPI.pCapFmt, nullptr);
+    if (SUCCEEDED(hr)) hr = gWASAPI.pCapCli->GetService(__uuidof(IAudioCaptureClient), (void**)&gWASAPI.pCap);
+    if (FAILED(hr)) {
+        SafeRelease(&gWASAPI.pCap);
+        SafeRelease(&gWASAPI.pCapCli);
+        SafeRelease(&gWASAPI.pCapDev);
+        if (gWASAPI.pCapFmt) { CoTaskMemFree(gWASAPI.pCapFmt); gWASAPI.pCapFmt = nullptr; }
+        return false;
+    }
+    return true;
+}
+
+// Log which step of opening the device failed, then close what is open
+static bool AudioFailed(const char* step, HRESULT hr) {
+    log_event(gLog, LogLevel::Error, "audio: %s failed (hr 0x%08x)", step, uint32_t(hr));
+    CloseAudio();
+    return false;
+}
 
+// Open the default endpoint with the requested buffer and start the
+// threads that feed on it. On failure everything opened so far is closed.
+// The caller's thread must have COM initialised (multithreaded).
+static bool OpenAudio() {
     // Device enumerator
-    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+    HRESULT hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
         __uuidof(IMMDeviceEnumerator), (void**)&gWASAPI.pEnum);
-    if (FAILED(hr)) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr)) return AudioFailed("CoCreateInstance(MMDeviceEnumerator)", hr);
 
     // Default render endpoint
     hr = gWASAPI.pEnum->GetDefaultAudioEndpoint(eRender, eConsole, &gWASAPI.pDev);
-    if (FAILED(hr)) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr)) return AudioFailed("GetDefaultAudioEndpoint", hr);
 
     // Audio client
     hr = gWASAPI.pDev->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, (void**)&gWASAPI.pCli);
-    if (FAILED(hr)) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr)) return AudioFailed("Activate(IAudioClient)", hr);
 
     // Mix format (shared-mode format)
     hr = gWASAPI.pCli->GetMixFormat(&gWASAPI.pMixFmt);
-    if (FAILED(hr) || !gWASAPI.pMixFmt) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr) || !gWASAPI.pMixFmt) return AudioFailed("GetMixFormat", hr);
 
     // Initialize shared, event-driven stream
-    REFERENCE_TIME hnsBufferDuration = 20 * 10000; // 20 ms
+    REFERENCE_TIME hnsBufferDuration = REFERENCE_TIME(gWASAPI.bufferMs * 10000.0f);
     hr = gWASAPI.pCli->Initialize(
         AUDCLNT_SHAREMODE_SHARED,
         AUDCLNT_STREAMFLAGS_EVENTCALLBACK | AUDCLNT_STREAMFLAGS_RATEADJUST,
@@ -375,64 +1366,758 @@ bool InitWASAPI(HWND) {
         0,
         gWASAPI.pMixFmt,
         nullptr);
-    if (FAILED(hr)) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr)) return AudioFailed("IAudioClient::Initialize", hr);
 
     // Buffer size
     hr = gWASAPI.pCli->GetBufferSize(&gWASAPI.bufferFrames);
-    if (FAILED(hr) || gWASAPI.bufferFrames == 0) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr) || gWASAPI.bufferFrames == 0) return AudioFailed("GetBufferSize", hr);
+
+    // Device latency, for extrapolating gestures to playback time
+    REFERENCE_TIME hnsLatency = 0;
+    if (SUCCEEDED(gWASAPI.pCli->GetStreamLatency(&hnsLatency)))
+        gWASAPI.streamLatency = double(hnsLatency) * 1e-7;
 
     // Event
     gWASAPI.hEvent = CreateEventW(nullptr, FALSE, FALSE, L"WASAPIEvent");
-    if (!gWASAPI.hEvent) { ShutdownWASAPI(); return false; }
+    if (!gWASAPI.hEvent) return AudioFailed("CreateEventW", HRESULT_FROM_WIN32(GetLastError()));
 
     hr = gWASAPI.pCli->SetEventHandle(gWASAPI.hEvent);
-    if (FAILED(hr)) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr)) return AudioFailed("SetEventHandle", hr);
 
     // Render client
     hr = gWASAPI.pCli->GetService(__uuidof(IAudioRenderClient), (void**)&gWASAPI.pRen);
-    if (FAILED(hr) || !gWASAPI.pRen) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr) || !gWASAPI.pRen) return AudioFailed("GetService(IAudioRenderClient)", hr);
+
+    // Vocoder modulator: live input and/or a WAV stand-in at the mix rate
+    if (gOptions.liveInput && !InitCapture())
+        log_event(gLog, LogLevel::Warn, "audio: no capture device, the vocoder uses the file stand-in");
+    if (!gOptions.modFile.empty() && !LoadModulatorFile(gOptions.modFile.c_str(), float(gWASAPI.pMixFmt->nSamplesPerSec)))
+        log_event(gLog, LogLevel::Warn, "vocoder: the /mod file could not be read as a WAV");
 
     // Pre-roll silence
     BYTE* pData = nullptr;
     hr = gWASAPI.pRen->GetBuffer(gWASAPI.bufferFrames, &pData);
-    if (FAILED(hr) || !pData) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr) || !pData) return AudioFailed("GetBuffer (pre-roll)", hr);
 
     memset(pData, 0, gWASAPI.bufferFrames * gWASAPI.pMixFmt->nBlockAlign);
     hr = gWASAPI.pRen->ReleaseBuffer(gWASAPI.bufferFrames, 0);
-    if (FAILED(hr)) { ShutdownWASAPI(); return false; }
+    if (FAILED(hr)) return AudioFailed("ReleaseBuffer (pre-roll)", hr);
+
+    // Loudness analysis, fed from the audio thread's tap
+    spsc_init(gAnalysis.tap, kTapFloats);
+    gAnalysis.sampleRate = float(gWASAPI.pMixFmt->nSamplesPerSec);
+    gAnalysis.running.store(true);
+    gAnalysis.hThread = CreateThread(nullptr, 0, AnalysisThreadMain, nullptr, 0, nullptr);
+    if (!gAnalysis.hThread) gAnalysis.running.store(false);
+
+    // Recorder (idle until R arms it)
+    spsc_init(gRecorder.tap, kRecordFloats);
+    gRecorder.channels = int(gWASAPI.pMixFmt->nChannels);
+    gRecorder.sampleRate = gWASAPI.pMixFmt->nSamplesPerSec;
+    gRecorder.running.store(true);
+    gRecorder.hThread = CreateThread(nullptr, 0, RecorderThreadMain, nullptr, 0, nullptr);
+    if (!gRecorder.hThread) gRecorder.running.store(false);
 
     // Audio thread
     gWASAPI.hAudioThread = CreateThread(nullptr, 0, AudioThreadMain, nullptr, 0, nullptr);
-    if (!gWASAPI.hAudioThread) { ShutdownWASAPI(); return false; }
+    if (!gWASAPI.hAudioThread) return AudioFailed("CreateThread (audio)", HRESULT_FROM_WIN32(GetLastError()));
 
+    log_event(gLog, LogLevel::Info, "audio: %u Hz, %d channels, %u-frame buffer (%.1f ms asked)",
+        uint32_t(gWASAPI.pMixFmt->nSamplesPerSec), int(gWASAPI.pMixFmt->nChannels), gWASAPI.bufferFrames,
+        double(gWASAPI.bufferMs));
     return true;
 }
 
+bool InitWASAPI(HWND) {
+    // COM init
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(hr)) {
+        log_event(gLog, LogLevel::Error, "audio: %s failed (hr 0x%08x)", "CoInitializeEx", uint32_t(hr));
+        return false;
+    }
+    gWASAPI.coInit = true;
+
+    if (!OpenAudio()) { ShutdownWASAPI(); return false; }
+    return true;
+}
+
+// ------------------------------
+// Offline render (/render script.txt out.wav)
+// ------------------------------
+//
+// Plays a gesture script through the same control queue and render path as
+// live input, with no device, and writes a stereo float WAV whose samples
+// start at byte kRenderWavHeader (so callers can map them directly). Each
+// render is its own process, so batches run in parallel across cores.
+
+static constexpr uint32_t kRenderWavHeader = 64;
+
+// Apply the events due by `t`, starting at `next`; returns the next pending
+static size_t ApplyScriptEvents(const std::vector<ScriptEvent>& ev, size_t next, double t, float sampleRate) {
+    for (; next < ev.size() && ev[next].t <= t; ++next) {
+        const ScriptEvent& s = ev[next];
+        ControlEvent e;
+        e.t = s.t;
+        e.x = s.a;
+        e.y = s.b;
+        e.source = ControlSource::Script;
+        switch (s.op) {
+        case ScriptOp::Pos:        e.type = ControlType::Position; break;
+        case ScriptOp::Gain:       e.type = ControlType::Gain; break;
+        case ScriptOp::Vibrato:    e.type = ControlType::Vibrato; break;
+        case ScriptOp::Latch:      e.type = ControlType::Latch; break;
+        case ScriptOp::Release:    e.type = ControlType::Release; e.x = 0.0f; break;
+        case ScriptOp::ReleaseAll: e.type = ControlType::Release; e.x = 1.0f; break;
+        case ScriptOp::Mode:
+            gParams.mode.store(std::max(1, std::min(4, int(s.a))));
+            continue;
+        case ScriptOp::Chord:
+            gParams.chord.mode.store(std::max(0, std::min(2, int(s.a))));
+            continue;
+        case ScriptOp::Master:
+            gParams.gain.masterDb.store(std::max(kMasterMinDb, std::min(kMasterMaxDb, s.a)));
+            continue;
+        case ScriptOp::Fx: {
+            const bool on = s.b > 0.5f;
+            switch (ScriptFx(int(s.a))) {
+            case ScriptFx::Eq:      gParams.eq.bypass.store(!on); break;
+            case ScriptFx::Comp:    gParams.dyn.enabled.store(on); break;
+            case ScriptFx::Harmony: gParams.harm.enabled.store(on); break;
+            case ScriptFx::Vocoder: gParams.voc.enabled.store(on); break;
+            case ScriptFx::Delay:   gParams.tape.enabled.store(on); break;
+            }
+        } continue;
+        case ScriptOp::End:
+            continue;
+        }
+        // Offline there is no one else to drain the queue, so never let it fill
+        if (control_pending(gControl) >= kControlQueueSize / 2) engine_drain(gEngine, sampleRate);
+        control_push(gControl, e);
+    }
+    engine_drain(gEngine, sampleRate);
+    return next;
+}
+
+// The whole script as interleaved stereo
+static void RenderScript(const std::vector<ScriptEvent>& ev, float sampleRate, std::vector<float>& out) {
+    engine_init(gEngine, sampleRate);
+    const UINT32 total = UINT32(script_length(ev) * sampleRate);
+    out.assign(size_t(total) * 2, 0.0f);
+    size_t next = 0;
+    for (UINT32 done = 0; done < total; ) {
+        const UINT32 n = std::min(kBlockFrames, total - done);
+        next = ApplyScriptEvents(ev, next, double(done) / sampleRate, sampleRate);
+        engine_render(gEngine, out.data() + size_t(done) * 2, n, 2, sampleRate);
+        done += n;
+    }
+}
+
+// Exit code: 0 done, 1 script unreadable or invalid, 2 WAV not written
+static int RunRender(const wchar_t* scriptPath, const wchar_t* wavPath) {
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+    std::vector<uint8_t> bytes;
+    std::vector<ScriptEvent> ev;
+    int errorLine = 0;
+    if (!ReadWholeFile(scriptPath, bytes) ||
+        !script_parse(reinterpret_cast<const char*>(bytes.data()), bytes.size(), ev, &errorLine))
+        return 1;
+    std::vector<float> audio;
+    RenderScript(ev, kSampleRate, audio);
+
+    std::string file(kRenderWavHeader, '\0');
+    wav_float_header(reinterpret_cast<uint8_t*>(&file[0]), kRenderWavHeader, 2, UINT32(kSampleRate),
+        uint64_t(audio.size()) * sizeof(float));
+    file.append(reinterpret_cast<const char*>(audio.data()), audio.size() * sizeof(float));
+    return WriteWholeFile(wavPath, file) ? 0 : 2;
+}
+
+// ------------------------------
+// Offline benchmarks (/bench)
+// ------------------------------
+
+static void BenchLine(std::string& report, const char* fmt, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    report += line;
+}
+
+// Whole chain through engine_render without a device; returns ns per frame
+static double BenchRender(float seconds, float sampleRate) {
+    static float out[kBlockFrames * 2];
+    engine_init(gEngine, sampleRate);
+    const UINT32 total = UINT32(seconds * sampleRate);
+    const double t0 = NowSeconds();
+    for (UINT32 done = 0; done < total; done += kBlockFrames)
+        engine_render(gEngine, out, kBlockFrames, 2, sampleRate);
+    return (NowSeconds() - t0) * 1e9 / total;
+}
+
+// Live voice plus `count` held drones
+static double BenchDrones(int count, float seconds, float sampleRate) {
+    static float out[kBlockFrames * 2];
+    engine_init(gEngine, sampleRate);
+    for (int d = 0; d < count; ++d) {
+        drone_latch(gSynth.drones, gParams.mode.load(), 110.0f * powf(1.5f, float(d)), 0.1f, 0.0f, sampleRate);
+        gSynth.drones.voice[d].level = 0.1f; // skip the fade-in
+    }
+    const UINT32 total = UINT32(seconds * sampleRate);
+    const double t0 = NowSeconds();
+    for (UINT32 done = 0; done < total; done += kBlockFrames)
+        engine_render(gEngine, out, kBlockFrames, 2, sampleRate);
+    return (NowSeconds() - t0) * 1e9 / total;
+}
+
+// A 10 s phrase scripted at 200 gesture events per second
+static double BenchScript(float sampleRate) {
+    std::vector<ScriptEvent> ev;
+    ScriptEvent e;
+    e.op = ScriptOp::Mode;
+    e.a = float(gParams.mode.load());
+    ev.push_back(e);
+    for (int k = 0; k < 2000; ++k) {
+        e.t = k * 0.005;
+        e.op = ScriptOp::Pos;
+        e.a = 0.5f + 0.3f * sinf(float(kTwoPi * 0.5 * e.t));
+        e.b = 0.5f;
+        ev.push_back(e);
+    }
+    e.t = 10.0;
+    e.op = ScriptOp::End;
+    ev.push_back(e);
+    std::vector<float> out;
+    const double t0 = NowSeconds();
+    RenderScript(ev, sampleRate, out);
+    return (NowSeconds() - t0) * 1e9 / (10.0 * sampleRate);
+}
+
+// Each mode's voice written out by hand, the reference for its chain
+static void HandVoice(int mode, VoiceFrame& frame, float incA, float incB, uint32_t& seed, float* out, UINT32 frames) {
+    float a = frame.phaseA, b = frame.phaseB;
+    switch (mode) {
+    case 1:
+        for (UINT32 i = 0; i < frames; ++i) {
+            a += incA; if (a >= kTwoPi) a -= kTwoPi;
+            b += incB; if (b >= kTwoPi) b -= kTwoPi;
+            out[i] = sine(a);
+        }
+        break;
+    case 2:
+        for (UINT32 i = 0; i < frames; ++i) {
+            a += incA; if (a >= kTwoPi) a -= kTwoPi;
+            b += incB; if (b >= kTwoPi) b -= kTwoPi;
+            const float s = sine(a);
+            out[i] = 0.70f * s + 0.45f * (s * sine(b));
+        }
+        break;
+    case 3:
+        for (UINT32 i = 0; i < frames; ++i) {
+            a += incA; if (a >= kTwoPi) a -= kTwoPi;
+            b += incB; if (b >= kTwoPi) b -= kTwoPi;
+            out[i] = fast_tanhf(0.85f * sine(a) + 0.25f * white_noise(seed));
+        }
+        break;
+    default:
+        for (UINT32 i = 0; i < frames; ++i) {
+            a += incA; if (a >= kTwoPi) a -= kTwoPi;
+            b += incB; if (b >= kTwoPi) b -= kTwoPi;
+            out[i] = 0.6f * soft_saw(a) + 0.4f * soft_tri(a);
+        }
+        break;
+    }
+    frame.phaseA = a;
+    frame.phaseB = b;
+}
+
+// Voice alone at a fixed 440 Hz, by hand or as the mode's chain; ns per sample
+static double BenchVoice(int mode, bool chain, float seconds, float sampleRate) {
+    static float out[kBlockFrames];
+    VoiceChains chains;
+    VoiceFrame f;
+    uint32_t seed = 0x12345678u;
+    const float incA = kTwoPi * 440.0f / sampleRate, incB = incA * 1.997f;
+    const UINT32 total = UINT32(seconds * sampleRate);
+    const double t0 = NowSeconds();
+    for (UINT32 done = 0; done < total; done += kBlockFrames) {
+        if (!chain) { HandVoice(mode, f, incA, incB, seed, out, kBlockFrames); continue; }
+        switch (mode) {
+        case 1:  chain_run(chains.mode1, f, incA, incB, out, kBlockFrames); break;
+        case 2:  chain_run(chains.mode2, f, incA, incB, out, kBlockFrames); break;
+        case 3:  chain_run(chains.mode3, f, incA, incB, out, kBlockFrames); break;
+        default: chain_run(chains.mode4, f, incA, incB, out, kBlockFrames); break;
+        }
+    }
+    return (NowSeconds() - t0) * 1e9 / total;
+}
+
+// Vocoder bank alone; returns ns per sample
+static double BenchVocoder(int bands, float seconds, float sampleRate) {
+    static VocoderState voc;
+    static float carrier[kBlockFrames], mod[kBlockFrames];
+    vocoder_reset(voc);
+    gParams.voc.bands.store(bands);
+    uint32_t seed = 1;
+    const UINT32 total = UINT32(seconds * sampleRate);
+    double elapsed = 0.0;
+    for (UINT32 done = 0; done < total; done += kBlockFrames) {
+        for (UINT32 i = 0; i < kBlockFrames; ++i) {
+            seed = 1664525u * seed + 1013904223u;
+            mod[i] = (seed >> 8) * (2.0f / 16777216.0f) - 1.0f;
+            carrier[i] = soft_saw(kTwoPi * float((done + i) % 218) / 218.0f);
+        }
+        const double t0 = NowSeconds();
+        vocoder_process(voc, gParams.voc, carrier, mod, kBlockFrames, sampleRate);
+        elapsed += NowSeconds() - t0;
+    }
+    return elapsed * 1e9 / total;
+}
+
+// Loudness meter alone (K-weighting, gating, 4x true peak); returns ns per frame
+static double BenchLoudness(float seconds, float sampleRate) {
+    static LoudnessMeter meter;
+    static float stereo[kBlockFrames * 2];
+    loudness_init(meter, sampleRate);
+    for (UINT32 i = 0; i < kBlockFrames; ++i)
+        stereo[2 * i] = stereo[2 * i + 1] = 0.3f * sinf(kTwoPi * 997.0f * float(i) / sampleRate);
+    const UINT32 total = UINT32(seconds * sampleRate);
+    const double t0 = NowSeconds();
+    for (UINT32 done = 0; done < total; done += kBlockFrames)
+        loudness_process(meter, stereo, kBlockFrames);
+    return (NowSeconds() - t0) * 1e9 / total;
+}
+
+struct DiskResult { double mbPerSec; uint32_t calls; };
+
+// Recorder write path: `seconds` of 32-bit audio appended one 128-frame
+// block at a time, as the recorder thread would, including the final flush
+static DiskResult BenchDiskWriter(const wchar_t* path, bool unbuffered, int channels, float sampleRate, float seconds) {
+    std::vector<float> block(size_t(kBlockFrames) * channels);
+    for (size_t i = 0; i < block.size(); ++i) block[i] = sinf(0.01f * float(i));
+    const UINT32 blocks = UINT32(seconds * sampleRate / kBlockFrames);
+    const size_t bytes = block.size() * sizeof(float);
+    DiskResult res = { 0.0, 0 };
+
+    const double t0 = NowSeconds();
+    if (unbuffered) {
+        UnbufferedWriter w;
+        if (!disk_writer_open(w, path)) return res;
+        for (UINT32 b = 0; b < blocks; ++b) disk_writer_append(w, block.data(), bytes);
+        res.calls = w.writes;
+        disk_writer_close(w, nullptr, 0);
+    } else {
+        BufferedWriter w;
+        if (!buffered_writer_open(w, path)) return res;
+        for (UINT32 b = 0; b < blocks; ++b) buffered_writer_append(w, block.data(), bytes);
+        res.calls = w.writes;
+        buffered_writer_close(w);
+    }
+    res.mbPerSec = double(blocks) * bytes / (NowSeconds() - t0) / 1e6;
+    return res;
+}
+
+// Loading the file back whole, as the modulator and sample loaders do
+static DiskResult BenchDiskReader(const wchar_t* path, bool unbuffered) {
+    std::vector<uint8_t> bytes;
+    DiskResult res = { 0.0, 1 };
+    const double t0 = NowSeconds();
+    if (unbuffered) {
+        UnbufferedReader rd;
+        if (!disk_reader_open(rd, path)) return res;
+        bytes.resize(size_t(rd.size));
+        size_t at = 0;
+        const uint8_t* data = nullptr;
+        uint32_t n = 0;
+        while (disk_reader_next(rd, data, n)) { memcpy(bytes.data() + at, data, n); at += n; }
+        res.calls = rd.reads;
+        disk_reader_close(rd);
+    } else if (!ReadWholeFile(path, bytes)) {
+        return res;
+    }
+    res.mbPerSec = double(bytes.size()) / (NowSeconds() - t0) / 1e6;
+    return res;
+}
+
+// Synthetic hand trajectories (normalised X over time)
+static float TrajectoryGlide(double t) { return 0.5f + 0.35f * sinf(float(kTwoPi * 0.4 * t)); }
+static float TrajectoryPhrase(double t) {
+    return 0.5f + 0.25f * sinf(float(kTwoPi * 0.9 * t)) + 0.1f * sinf(float(kTwoPi * 2.3 * t + 1.0));
+}
+static float TrajectoryVibrato(double t) {
+    return 0.45f + 0.1f * sinf(float(kTwoPi * 0.2 * t)) + 0.01f * sinf(float(kTwoPi * 5.5 * t));
+}
+static float TrajectoryLeaps(double t) { // minimum-jerk moves between held notes
+    const double period = 0.6, move = 0.15;
+    const int    k = int(t / period);
+    const float  from = 0.2f + 0.15f * float((k * 7) % 5), to = 0.2f + 0.15f * float(((k + 1) * 7) % 5);
+    const float  u = float(std::min(1.0, std::max(0.0, (t - k * period - (period - move)) / move)));
+    return from + (to - from) * u * u * u * (10.0f + u * (-15.0f + 6.0f * u));
+}
+
+struct PredictionResult { double rmsCents, lagMs; };
+
+// Stand-in for a loopback latency measurement: replays a trajectory as
+// 125 Hz pixel-quantised events through the per-event predictor and the
+// per-block extrapolation, with a fixed render-to-speaker latency.
+// Error is against the true hand position at playback time; the lag is
+// the time shift that best aligns what is heard with the hand.
+static PredictionResult BenchPrediction(float (*trajectory)(double), bool predict, double latency) {
+    const double eventPeriod = 1.0 / 125.0, queueDelay = 0.002;
+    const double block = kBlockFrames / 48000.0, seconds = 30.0, pixels = 900.0;
+    const double centsPerUnit = 1200.0 * log2(double(kMaxHz / kMinHz));
+    GesturePredictor pred;
+    GestureSample g;
+    float measured = 0.0f;
+    double nextEvent = 0.0;
+    std::vector<double> heardAt;
+    std::vector<float> heard;
+    for (double tb = 0.0; tb < seconds; tb += block) {
+        // Events sampled at nextEvent, delivered (and timestamped) queueDelay later
+        while (nextEvent + queueDelay <= tb) {
+            measured = float(floor(trajectory(nextEvent) * pixels) / pixels);
+            const double t = nextEvent + queueDelay;
+            predictor_update(pred, measured, t);
+            g.t = t; g.x = pred.x; g.vx = pred.v; g.cx = predictor_confidence(pred, kPredictTolerance);
+            nextEvent += eventPeriod;
+        }
+        const double tp = tb + latency;
+        heardAt.push_back(tp);
+        heard.push_back(predict ? predict_position(g.x, g.vx, g.cx, g.t, tb, tp) : measured);
+    }
+
+    auto rms = [&](double shift) {
+        double sum = 0.0;
+        for (size_t i = 0; i < heard.size(); ++i) {
+            const double e = heard[i] - trajectory(heardAt[i] - shift);
+            sum += e * e;
+        }
+        return sqrt(sum / double(heard.size()));
+    };
+    PredictionResult res;
+    res.rmsCents = rms(0.0) * centsPerUnit;
+    res.lagMs = 0.0;
+    double best = res.rmsCents;
+    for (double shift = 0.0005; shift <= 0.08; shift += 0.0005) {
+        const double e = rms(shift) * centsPerUnit;
+        if (e < best) { best = e; res.lagMs = shift * 1000.0; }
+    }
+    return res;
+}
+
+struct FloodResult {
+    uint32_t offered, pushed, dropped, merged, peak, lost;
+    double   cpuPct, renderUs, worstUs;
+};
+
+struct FloodProducer {
+    double            rate = 0.0;
+    std::atomic<bool> running{ true };
+    uint32_t          offered = 0, lost = 0;
+    double            cpu = 0.0;  // seconds busy
+};
+
+static double ThreadCpuSeconds(HANDLE thread) {
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(thread, &created, &exited, &kernel, &user)) return 0.0;
+    auto seconds = [](const FILETIME& f) { return double((uint64_t(f.dwHighDateTime) << 32) | f.dwLowDateTime) * 1e-7; };
+    return seconds(kernel) + seconds(user);
+}
+
+// Stand-in for the UI thread behind a hostile controller: `rate` events a
+// second, evenly timestamped and pushed in 1 ms bursts. They cycle through a
+// mouse position (as WM_MOUSEMOVE sends), a raw mouse motion, a MIDI-style
+// gain and an OSC-style position from the host API. Every 50 ms
+// a latch or release goes in as a key press would; one refused is lost.
+DWORD WINAPI FloodThreadMain(LPVOID arg) {
+    FloodProducer& fp = *static_cast<FloodProducer*>(arg);
+    const double t0 = NowSeconds();
+    uint64_t sent = 0;
+    uint32_t actions = 0;
+    while (fp.running.load()) {
+        const double now = NowSeconds();
+        for (const uint64_t due = uint64_t((now - t0) * fp.rate); sent < due; ++sent) {
+            ControlEvent e;
+            e.t = t0 + double(sent) / fp.rate;
+            const float sweep = float(sent % 997) / 997.0f;
+            switch (sent % 4) {
+            case 0:  e.type = ControlType::Position; e.source = ControlSource::Mouse; e.x = sweep; e.y = 0.4f; break;
+            case 1:  e.type = ControlType::Motion;   e.source = ControlSource::RawMouse; e.x = 0.001f; break;
+            case 2:  e.type = ControlType::Gain;     e.source = ControlSource::Host;  e.x = sweep; break;
+            default: e.type = ControlType::Position; e.source = ControlSource::Host;  e.x = 1.0f - sweep; e.y = 0.6f; break;
+            }
+            control_push(gControl, e);
+        }
+        if (now - t0 >= 0.05 * (actions + 1)) {
+            ControlEvent e;
+            e.t = now;
+            e.type = actions % 2 ? ControlType::Release : ControlType::Latch;
+            e.source = ControlSource::Keyboard;
+            if (!control_push(gControl, e)) ++fp.lost;
+            ++actions;
+        }
+        Sleep(1);
+    }
+    fp.offered = uint32_t(sent) + actions;
+    fp.cpu = ThreadCpuSeconds(GetCurrentThread());
+    return 0;
+}
+
+// 10 ms device buffers drained and rendered in real time while
+// FloodThreadMain pushes `rate` events a second (0: none, the baseline)
+static FloodResult BenchFlood(double rate, double seconds, float sampleRate) {
+    static float out[kBlockFrames * 2];
+    const UINT32 bufferFrames = UINT32(sampleRate * 0.010f);
+    engine_init(gEngine, sampleRate);
+    engine_drain(gEngine, sampleRate); // start empty
+    gControl.peak.store(0);
+    const uint32_t pushed = gControl.pushed.load(), dropped = gControl.dropped.load(), merged = gControl.coalesced.load();
+
+    FloodProducer fp;
+    fp.rate = rate;
+    HANDLE hThread = rate > 0.0 ? CreateThread(nullptr, 0, FloodThreadMain, &fp, 0, nullptr) : nullptr;
+    double busy = 0.0, worst = 0.0;
+    int buffers = 0;
+    const double t0 = NowSeconds();
+    for (double next = t0; next < t0 + seconds; next += bufferFrames / double(sampleRate)) {
+        while (NowSeconds() < next) Sleep(1);
+        const double b0 = NowSeconds();
+        engine_drain(gEngine, sampleRate);
+        for (UINT32 done = 0; done < bufferFrames; done += kBlockFrames)
+            engine_render(gEngine, out, std::min(kBlockFrames, bufferFrames - done), 2, sampleRate);
+        const double b = NowSeconds() - b0;
+        busy += b;
+        worst = std::max(worst, b);
+        ++buffers;
+    }
+    if (hThread) {
+        fp.running.store(false);
+        WaitForSingleObject(hThread, INFINITE);
+        CloseHandle(hThread);
+    }
+    engine_drain(gEngine, sampleRate);
+
+    FloodResult r;
+    r.offered = fp.offered;
+    r.pushed = gControl.pushed.load() - pushed;
+    r.dropped = gControl.dropped.load() - dropped;
+    r.merged = gControl.coalesced.load() - merged;
+    r.peak = gControl.peak.load();
+    r.lost = fp.lost;
+    r.cpuPct = 100.0 * fp.cpu / seconds;
+    r.renderUs = busy * 1e6 / std::max(1, buffers);
+    r.worstUs = worst * 1e6;
+    return r;
+}
+
+static void RunBenchmarks(const wchar_t* path) {
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+    const float sampleRate = 48000.0f;
+    const float seconds = 10.0f;
+    std::string r;
+
+    gParams.targetHz.store(440.0f);
+    gParams.targetGain.store(0.5f);
+    gParams.mode.store(4);
+
+    BenchLine(r, "Modulation routing (a = audio rate, k = every %d samples, b = per block)\n", int(kControlFrames));
+    for (const ModRoute& m : kModRoutes)
+        BenchLine(r, "  %c  %-22s -> %s\n", mod_rate_tag(m.rate), m.source, m.destination);
+
+    gParams.vibratoDepth.store(1.0f);
+    BenchLine(r, "\nVoice with vibrato by control period (ns/frame)\n");
+    for (int k : { 1, 16, 32 }) {
+        gParams.controlFrames.store(k);
+        BenchLine(r, "  every %2d samples         %8.1f\n", k, BenchRender(seconds, sampleRate));
+    }
+    gParams.controlFrames.store(int(kControlFrames));
+    gParams.vibratoDepth.store(0.0f);
+
+    // The share of blocks that took the fused path is counted, not assumed:
+    // a row whose chain could not fuse says so
+    BenchLine(r, "\nOutput path, common chain (ns/frame, %% of blocks fused)\n");
+    const double blocks = double((UINT32(seconds * sampleRate) + kBlockFrames - 1) / kBlockFrames);
+    const struct { const char* name; bool fused, eq; } paths[] = {
+        { "generic, one pass each", false, true }, { "fused, default eq", true, true }, { "fused, eq bypassed", true, false },
+    };
+    for (const auto& path : paths) {
+        gParams.fusedOutput.store(path.fused);
+        gParams.eq.bypass.store(!path.eq);
+        const uint64_t fused = gSynth.fusedBlocks;
+        const double ns = BenchRender(seconds, sampleRate);
+        const double share = 100.0 * double(gSynth.fusedBlocks - fused) / blocks;
+        BenchLine(r, "  %-24s %8.1f %7.1f%s\n", path.name, ns, share,
+            path.fused && share < 99.0 ? "  (did not fuse)" : "");
+    }
+    gParams.fusedOutput.store(true);
+    gParams.eq.bypass.store(true);
+
+    BenchLine(r, "\nRender chain (ns/frame, %d-frame blocks)\n", int(kBlockFrames));
+    BenchLine(r, "  dry                      %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.eq.bypass.store(false);
+    BenchLine(r, "  + eq                     %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.dyn.enabled.store(true);
+    BenchLine(r, "  + dynamics               %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.harm.enabled.store(true);
+    BenchLine(r, "  + harmonizer (psola)     %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.harm.highQuality.store(true);
+    BenchLine(r, "  + harmonizer (vocoder)   %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.harm.enabled.store(false);
+    gParams.harm.highQuality.store(false);
+    gParams.voc.enabled.store(true);
+    BenchLine(r, "  + channel vocoder (32)   %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.voc.enabled.store(false);
+    gParams.tape.enabled.store(true);
+    BenchLine(r, "  + tape delay             %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.tape.sync.store(false);
+    gParams.tape.timeMs.store(2000.0f);
+    BenchLine(r, "  + tape delay at 2 s      %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.tape.sync.store(true);
+    gParams.tape.enabled.store(false);
+    gParams.chord.mode.store(int(ChordMode::Chord));
+    BenchLine(r, "  + chord (3 pool voices)  %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.chord.mode.store(int(ChordMode::Arp));
+    BenchLine(r, "  + arpeggiator            %8.1f\n", BenchRender(seconds, sampleRate));
+    gParams.chord.mode.store(int(ChordMode::Off));
+
+    BenchLine(r, "\nOffline render (ns/frame)\n");
+    BenchLine(r, "  engine_render directly   %8.1f\n", BenchRender(seconds, sampleRate));
+    BenchLine(r, "  gesture script, 200 ev/s %8.1f\n", BenchScript(sampleRate));
+    gParams.targetHz.store(440.0f);
+    gParams.targetGain.store(0.5f);
+
+    BenchLine(r, "\nVoice per mode, 440 Hz (ns/sample: hand-written loop, chain)\n");
+    for (int m = 1; m <= 4; ++m)
+        BenchLine(r, "  mode %d                   %8.2f %8.2f\n", m,
+            BenchVoice(m, false, seconds, sampleRate), BenchVoice(m, true, seconds, sampleRate));
+
+    BenchLine(r, "\nHeld drones, table playback (ns/frame incl. live voice)\n");
+    for (int n : { 0, 1, 4, kDroneVoices })
+        BenchLine(r, "  %d drones                 %8.1f\n", n, BenchDrones(n, seconds, sampleRate));
+
+    BenchLine(r, "\nChannel vocoder bank (ns/sample, ns/sample/band)\n");
+    for (int bands = 16; bands <= kVocMaxBands; bands += 16) {
+        const double ns = BenchVocoder(bands, seconds, sampleRate);
+        BenchLine(r, "  %2d bands                 %8.1f %8.2f\n", bands, ns, ns / bands);
+    }
+    gParams.voc.bands.store(32);
+
+    BenchLine(r, "\nLoudness meter, analysis thread (ns/frame)  %8.1f\n", BenchLoudness(seconds, sampleRate));
+
+    // Multitrack recording load: 8 x 32-bit at 96 kHz = 3.07 MB/s real time
+    // The file is read back unbuffered first: neither writer nor that reader
+    // leaves it in the cache, so the buffered read is cold too
+    const wchar_t* diskPath = L"theremin_bench_rec.tmp";
+    BenchLine(r, "\nRecorder, 8 ch x 96 kHz float, 20 s (MB/s, write calls)\n");
+    const DiskResult buffered = BenchDiskWriter(diskPath, false, 8, 96000.0f, 20.0f);
+    const DiskResult unbuffered = BenchDiskWriter(diskPath, true, 8, 96000.0f, 20.0f);
+    BenchLine(r, "  buffered, per block      %8.1f %8u\n", buffered.mbPerSec, buffered.calls);
+    BenchLine(r, "  unbuffered, overlapped   %8.1f %8u\n", unbuffered.mbPerSec, unbuffered.calls);
+    BenchLine(r, "\nLoading the take back whole (MB/s, read calls)\n");
+    const DiskResult readUnbuffered = BenchDiskReader(diskPath, true);
+    const DiskResult readBuffered = BenchDiskReader(diskPath, false);
+    BenchLine(r, "  buffered, one read       %8.1f %8u\n", readBuffered.mbPerSec, readBuffered.calls);
+    BenchLine(r, "  unbuffered, overlapped   %8.1f %8u\n", readUnbuffered.mbPerSec, readUnbuffered.calls);
+    DeleteFileW(diskPath);
+
+    // Typical shared-mode path: ~10 ms queued + ~10 ms device latency
+    const double latency = 0.020;
+    BenchLine(r, "\nGesture prediction at %.0f ms output latency (RMS cents / effective lag ms)\n", latency * 1000.0);
+    BenchLine(r, "                               held             predicted\n");
+    const struct { const char* name; float (*fn)(double); } trajectories[] = {
+        { "slow glide", TrajectoryGlide }, { "phrase", TrajectoryPhrase },
+        { "vibrato", TrajectoryVibrato }, { "leaps", TrajectoryLeaps },
+    };
+    for (const auto& t : trajectories) {
+        const PredictionResult held = BenchPrediction(t.fn, false, latency);
+        const PredictionResult pred = BenchPrediction(t.fn, true, latency);
+        BenchLine(r, "  %-12s %12.1f %6.1f    %8.1f %6.1f\n", t.name, held.rmsCents, held.lagMs, pred.rmsCents, pred.lagMs);
+    }
+
+    // Queue of kControlQueueSize; latch/release must never be lost, and the
+    // render cost should stay flat however fast the events come
+    BenchLine(r, "\nInput flood against 10 ms buffers in real time, 2 s per rate (producer CPU %% of a core, render us/buffer)\n");
+    BenchLine(r, "  events/s   offered   pushed  dropped   merged  peak  lost   cpu %%   render    worst\n");
+    timeBeginPeriod(1);
+    for (double rate : { 0.0, 1e3, 1e4, 1e5 }) {
+        const FloodResult f = BenchFlood(rate, 2.0, sampleRate);
+        BenchLine(r, "  %8.0f  %8u %8u %8u %8u %5u %5u %7.1f %8.1f %8.1f\n", rate, f.offered, f.pushed, f.dropped,
+            f.merged, f.peak, f.lost, f.cpuPct, f.renderUs, f.worstUs);
+    }
+    timeEndPeriod(1);
+
+    WriteWholeFile(path, r);
+}
 
 // ------------------------------
 // WinMain
 // ------------------------------
 
+static void ParseCommandLine() {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (!argv) return;
+    for (int i = 1; i < argc; ++i) {
+        std::wstring a = argv[i];
+        if (a == L"/live") gOptions.liveInput = true;
+        else if (a == L"/mod" && i + 1 < argc) gOptions.modFile = argv[++i];
+        else if (a == L"/loudness" && i + 1 < argc) gOptions.loudnessCsv = argv[++i];
+        else if (a == L"/config" && i + 1 < argc) gOptions.configFile = argv[++i];
+        else if (a == L"/log" && i + 1 < argc) gOptions.logFile = argv[++i];
+        else if (a == L"/render" && i + 2 < argc) {
+            gOptions.renderScript = argv[++i];
+            gOptions.renderOut = argv[++i];
+        }
+        else if (a == L"/bench") {
+            gOptions.bench = true;
+            if (i + 1 < argc && argv[i + 1][0] != L'/') gOptions.benchOut = argv[++i];
+        }
+    }
+    LocalFree(argv);
+}
+
 int APIENTRY wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow) {
+    ParseCommandLine();
+    eq_default_bands(gParams.eq);
+
+    if (gOptions.bench) {
+        RunBenchmarks(gOptions.benchOut.c_str());
+        return 0;
+    }
+    if (!gOptions.renderScript.empty())
+        return RunRender(gOptions.renderScript.c_str(), gOptions.renderOut.c_str());
+
+    log_thread_name(gLog, "ui");
+    StartLog();
+
     // Window class
     WNDCLASSW wc{};
     wc.lpfnWndProc = WndProc;
     wc.hInstance = hInst;
     wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+    wc.hbrBackground = nullptr; // painted from the canvas
     wc.lpszClassName = L"ThereminWindowClass";
     RegisterClassW(&wc);
 
     // Window
-    gHWND = CreateWindowExW(0, wc.lpszClassName, L"Theremin (WASAPI) - Mouse X=Pitch, Y=Volume | 1-4 Modes | Shift Vibrato | Space Mute",
+    gHWND = CreateWindowExW(0, wc.lpszClassName, L"Theremin (WASAPI) - Mouse X=Pitch, Y=Volume (pen pressure, pad trigger) | 1-4 Modes | Shift Vibrato | Space Mute | +/- Master | G Auto-gain | E EQ | C Comp | H Harmony (Q HQ) | V Vocoder | D Delay | K Chord/Arp | Enter Latch drone (Bksp/Del release) | A Adaptive glide | P Predict | I Raw mouse | L Reset loudness | R Record (T stems) | Drop a WAV: vocoder modulator",
         WS_OVERLAPPEDWINDOW, CW_USEDEFAULT, CW_USEDEFAULT, 900, 300,
         nullptr, nullptr, hInst, nullptr);
-    if (!gHWND) return 0;
+    if (!gHWND) { StopLog(); return 0; }
     ShowWindow(gHWND, nCmdShow);
+    DragAcceptFiles(gHWND, TRUE);
+    StartConfig();
+    InitVisuals();
+    StartInput();
 
     // Init audio
     if (!InitWASAPI(gHWND)) {
         MessageBoxW(gHWND, L"Failed to initialize WASAPI.", L"Error", MB_OK | MB_ICONERROR);
         DestroyWindow(gHWND);
+        StopInput();
+        StopConfig();
+        ShutdownVisuals();
+        StopLog();
         return 0;
     }
 
@@ -443,6 +2128,10 @@ int APIENTRY wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow) {
         DispatchMessageW(&msg);
     }
 
+    StopInput();
+    StopConfig();
     ShutdownWASAPI();
+    ShutdownVisuals();
+    StopLog();
     return 0;
 }
@@ -0,0 +1,152 @@
+// Theremin engine as a shared library: the C API over Engine.h
+#include <xmmintrin.h>
+#include <cstdlib>
+#include <new>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#include "Engine.h"
+#include "TheraminApi.h"
+
+static_assert(int(ControlType::Position) == THEREMIN_EVENT_POSITION && int(ControlType::Release) == THEREMIN_EVENT_RELEASE,
+    "event types are passed straight through to the control queue");
+static_assert(int(EqBandType::HighPass) == THEREMIN_EQ_HIGHPASS && int(EqBandType::LowPass) == THEREMIN_EQ_LOWPASS,
+    "EQ band types are passed straight through");
+
+struct theremin_engine {
+    Engine engine;
+    float  sampleRate = kSampleRate;
+};
+
+// Engines hold cache-line aligned queues, so they get aligned allocations
+static void* AlignedAlloc(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, alignof(theremin_engine));
+#else
+    void* p = nullptr;
+    return posix_memalign(&p, alignof(theremin_engine), size) == 0 ? p : nullptr;
+#endif
+}
+
+static void AlignedFree(void* p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+extern "C" {
+
+int theremin_api_version(void) {
+    return THEREMIN_API_VERSION;
+}
+
+theremin_engine* theremin_create(float sample_rate) {
+    if (!(sample_rate >= 8000.0f && sample_rate <= 192000.0f)) return nullptr;
+    void* mem = AlignedAlloc(sizeof(theremin_engine));
+    if (!mem) return nullptr;
+    theremin_engine* t = nullptr;
+    try {
+        t = new (mem) theremin_engine();
+        t->sampleRate = sample_rate;
+        engine_init(t->engine, sample_rate);
+    } catch (const std::bad_alloc&) {
+        if (t) t->~theremin_engine();
+        AlignedFree(mem);
+        return nullptr;
+    }
+    return t;
+}
+
+void theremin_destroy(theremin_engine* engine) {
+    if (!engine) return;
+    engine->~theremin_engine();
+    AlignedFree(engine);
+}
+
+int theremin_process(theremin_engine* engine, float* out, uint32_t frames, int channels) {
+    if (!engine || (!out && frames) || channels < 1 || channels > 2) return THEREMIN_ERR_ARGUMENT;
+    // Flush denormals to zero while rendering; the host's mode is restored
+    const unsigned int csr = _mm_getcsr();
+    _mm_setcsr(csr | 0x8040);
+    Engine& e = engine->engine;
+    engine_drain(e, engine->sampleRate);
+    for (uint32_t done = 0; done < frames; ) {
+        const uint32_t n = std::min(kBlockFrames, frames - done);
+        engine_render(e, out + size_t(done) * channels, n, channels, engine->sampleRate);
+        done += n;
+    }
+    _mm_setcsr(csr);
+    return THEREMIN_OK;
+}
+
+int theremin_set_param(theremin_engine* engine, int param, float value) {
+    if (!engine || !(value == value)) return THEREMIN_ERR_ARGUMENT;
+    SynthParams& p = engine->engine.params;
+    const bool on = value > 0.5f;
+    switch (param) {
+    case THEREMIN_PARAM_MODE:
+        if (value < 1.0f || value > 4.0f) return THEREMIN_ERR_ARGUMENT;
+        p.mode.store(int(value));
+        break;
+    case THEREMIN_PARAM_MUTE:               p.mute.store(on); break;
+    case THEREMIN_PARAM_MASTER_DB:
+        p.gain.masterDb.store(std::max(kMasterMinDb, std::min(kMasterMaxDb, value)));
+        break;
+    case THEREMIN_PARAM_CHORD_MODE:
+        if (value < 0.0f || value > 2.0f) return THEREMIN_ERR_ARGUMENT;
+        p.chord.mode.store(int(value));
+        break;
+    case THEREMIN_PARAM_CHORD_TONIC_HZ:
+        if (value < kMinHz * 0.5f || value > kMaxHz) return THEREMIN_ERR_ARGUMENT;
+        p.chord.tonicHz.store(value);
+        break;
+    case THEREMIN_PARAM_CONTROL_FRAMES:
+        if (value < 1.0f || value > float(kMaxControlFrames)) return THEREMIN_ERR_ARGUMENT;
+        p.controlFrames.store(int(value));
+        break;
+    case THEREMIN_PARAM_ADAPTIVE_SMOOTHING: p.adaptiveSmoothing.store(on); break;
+    case THEREMIN_PARAM_EQ:                 p.eq.bypass.store(!on); break;
+    case THEREMIN_PARAM_COMPRESSOR:         p.dyn.enabled.store(on); break;
+    case THEREMIN_PARAM_HARMONY:            p.harm.enabled.store(on); break;
+    case THEREMIN_PARAM_VOCODER:            p.voc.enabled.store(on); break;
+    case THEREMIN_PARAM_DELAY:              p.tape.enabled.store(on); break;
+    case THEREMIN_PARAM_DELAY_BPM:
+        p.tape.bpm.store(std::max(20.0f, std::min(300.0f, value)));
+        break;
+    default:
+        return THEREMIN_ERR_ARGUMENT;
+    }
+    return THEREMIN_OK;
+}
+
+int theremin_push_event(theremin_engine* engine, const theremin_event* event) {
+    if (!engine || !event || event->type < THEREMIN_EVENT_POSITION || event->type > THEREMIN_EVENT_RELEASE)
+        return THEREMIN_ERR_ARGUMENT;
+    ControlEvent e;
+    e.t = event->time;
+    e.x = event->x;
+    e.y = event->y;
+    e.type = ControlType(event->type);
+    e.source = ControlSource::Host;
+    return control_push(engine->engine.control, e) ? THEREMIN_OK : THEREMIN_ERR_FULL;
+}
+
+int theremin_set_eq_band(theremin_engine* engine, int band, int type, float hz, float gain_db, float q, int enabled) {
+    if (!engine || band < 0 || band >= kEqBands || type < THEREMIN_EQ_HIGHPASS || type > THEREMIN_EQ_LOWPASS ||
+        !(hz >= kEqMinHz && hz <= kEqMaxHz) || !(gain_db >= -kEqMaxGainDb && gain_db <= kEqMaxGainDb) ||
+        !(q >= kEqMinQ && q <= kEqMaxQ))
+        return THEREMIN_ERR_ARGUMENT;
+    EqBand b;
+    b.type = EqBandType(type);
+    b.hz = hz; b.gainDb = gain_db; b.q = q;
+    b.enabled = enabled != 0;
+    EqParams& eq = engine->engine.params.eq;
+    eq_set_band(eq, band, b);
+    eq_commit(eq);
+    return THEREMIN_OK;
+}
+
+} // extern "C"
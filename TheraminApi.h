@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+
+/*
+ * Theremin engine C API (TheraminEngine.dll)
+ *
+ * Each engine is an independent instance: create as many as you need. All
+ * memory is allocated by theremin_create; theremin_process renders into
+ * the caller's buffer and never allocates, locks or makes system calls.
+ *
+ * Threads: theremin_process runs on one thread at a time per engine (the
+ * host's audio thread). theremin_set_param and theremin_push_event may be
+ * called from any thread, including several at once. Events are applied
+ * in arrival order at the start of the next theremin_process call.
+ */
+
+#if defined(_WIN32)
+#  if defined(THEREMIN_BUILD_DLL)
+#    define THEREMIN_API __declspec(dllexport)
+#  else
+#    define THEREMIN_API __declspec(dllimport)
+#  endif
+#else
+#  define THEREMIN_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define THEREMIN_API_VERSION 2
+
+typedef struct theremin_engine theremin_engine;
+
+/* Return codes */
+#define THEREMIN_OK            0
+#define THEREMIN_ERR_ARGUMENT -1  /* null engine/buffer, or a value out of range */
+#define THEREMIN_ERR_FULL     -2  /* event queue (nearly) full, the event was dropped */
+
+/* Gesture events, the same ones the app's mouse, pen and pad produce */
+typedef enum theremin_event_type {
+    THEREMIN_EVENT_POSITION = 0, /* x (pitch) and y (0 = loud) over the play area, 0..1 */
+    THEREMIN_EVENT_MOTION = 1,   /* relative move: x/y in play-area widths/heights */
+    THEREMIN_EVENT_GAIN = 2,     /* volume 0..1 in x, keeps the pitch */
+    THEREMIN_EVENT_VIBRATO = 3,  /* depth 0..1 in x */
+    THEREMIN_EVENT_LATCH = 4,    /* freeze the voice into a drone */
+    THEREMIN_EVENT_RELEASE = 5   /* fade the newest drone; all of them when x > 0.5 */
+} theremin_event_type;
+
+typedef struct theremin_event {
+    double time;   /* seconds on a monotonic clock; sets the gesture speed */
+    float  x, y;
+    int    type;   /* theremin_event_type */
+} theremin_event;
+
+/* Parameters (values are floats; switches are 0 or 1) */
+typedef enum theremin_param {
+    THEREMIN_PARAM_MODE = 0,            /* timbre 1..4 */
+    THEREMIN_PARAM_MUTE = 1,
+    THEREMIN_PARAM_MASTER_DB = 2,       /* -40..12 */
+    THEREMIN_PARAM_CHORD_MODE = 3,      /* 0 off, 1 chord, 2 arpeggio */
+    THEREMIN_PARAM_CHORD_TONIC_HZ = 4,  /* key of the chord scale */
+    THEREMIN_PARAM_CONTROL_FRAMES = 5,  /* pitch control period, 1..64 samples */
+    THEREMIN_PARAM_ADAPTIVE_SMOOTHING = 6,
+    THEREMIN_PARAM_EQ = 7,
+    THEREMIN_PARAM_COMPRESSOR = 8,
+    THEREMIN_PARAM_HARMONY = 9,
+    THEREMIN_PARAM_VOCODER = 10,
+    THEREMIN_PARAM_DELAY = 11,
+    THEREMIN_PARAM_DELAY_BPM = 12       /* delay and arpeggio tempo, 20..300 */
+} theremin_param;
+
+/* EQ band types (6 bands, index 0..5; THEREMIN_PARAM_EQ bypasses them all) */
+typedef enum theremin_eq_type {
+    THEREMIN_EQ_HIGHPASS = 0,
+    THEREMIN_EQ_LOWSHELF = 1,
+    THEREMIN_EQ_PEAK = 2,
+    THEREMIN_EQ_HIGHSHELF = 3,
+    THEREMIN_EQ_LOWPASS = 4
+} theremin_eq_type;
+
+THEREMIN_API int theremin_api_version(void);
+
+/* Returns null if the sample rate is outside 8000..192000 Hz or memory runs out */
+THEREMIN_API theremin_engine* theremin_create(float sample_rate);
+THEREMIN_API void theremin_destroy(theremin_engine* engine);
+
+/* Render `frames` interleaved float frames into `out` (1 or 2 channels) */
+THEREMIN_API int theremin_process(theremin_engine* engine, float* out, uint32_t frames, int channels);
+
+THEREMIN_API int theremin_set_param(theremin_engine* engine, int param, float value);
+THEREMIN_API int theremin_push_event(theremin_engine* engine, const theremin_event* event);
+
+/* Any thread: set one EQ band (hz 20..20000, gain_db -24..24 for shelves
+ * and peaks, q 0.1..20), or turn it off. The change is ramped in over the
+ * next block. Since API version 2. */
+THEREMIN_API int theremin_set_eq_band(theremin_engine* engine, int band, int type, float hz, float gain_db, float q, int enabled);
+
+#ifdef __cplusplus
+}
+#endif
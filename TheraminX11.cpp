@@ -0,0 +1,685 @@
+// Linux frontend: X11 window, XInput2 pointer input, ALSA output
+//
+// Plays the engine through the C API (TheraminApi.h), so the control queue
+// is the same one the Win32 app feeds; only the window, input and audio
+// device differ. Build it on the stage machines with
+//
+//   g++ -std=c++14 -O2 -pthread TheraminX11.cpp TheraminApi.cpp -o theremin-x11
+//       -lX11 -lXext -lXi -lasound
+//
+// and run it headless under Xvfb, with no sound card:
+//
+//   Xvfb :99 & DISPLAY=:99 ./theremin-x11 --null-audio --quit-after 5
+//
+// Options: --config <file.cfg> (keys and EQ bands, as in the Win32 app),
+// --null-audio (render in real time and discard), --quit-after <seconds>.
+#include "Config.h"
+#include "TheraminApi.h"
+
+// Xlib's macros (None, Status...) would clash with the names above
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XInput2.h>
+#include <X11/extensions/XShm.h>
+#include <alsa/asoundlib.h>
+#include <emmintrin.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <time.h>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#undef None
+
+// ------------------------------
+// Clock and options
+// ------------------------------
+
+// Event times for the engine: seconds on the monotonic clock
+static double NowSeconds() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return double(t.tv_sec) + double(t.tv_nsec) * 1e-9;
+}
+
+struct Options {
+    std::string configFile = "theremin.cfg";
+    bool        nullAudio = false;
+    double      quitAfter = 0.0;   // seconds, 0 = run until closed
+};
+static Options gOptions;
+
+static AppConfig gConfig;
+static theremin_engine* gEngine = nullptr;
+
+// The C API has no getters, so the frontend keeps what it last set
+struct FrontState {
+    int   mode = 1;
+    bool  mute = false, eq = true, comp = false, harmony = false, vocoder = false, delay = false;
+    bool  adaptive = true;
+    int   chord = 0;
+    float masterDb = 0.0f;
+    bool  raw = false;             // XI_RawMotion instead of absolute positions
+    float x = 0.5f, y = 1.0f;      // last position sent (raw motion integrates it)
+    float vibrato = 0.0f;          // Shift depth last pushed
+    uint32_t pushed = 0, dropped = 0;
+};
+static FrontState gState;
+
+// Every setting at once, so the engine matches gState from the start
+static void SendState() {
+    const FrontState& s = gState;
+    theremin_set_param(gEngine, THEREMIN_PARAM_MODE, float(s.mode));
+    theremin_set_param(gEngine, THEREMIN_PARAM_MUTE, s.mute);
+    theremin_set_param(gEngine, THEREMIN_PARAM_EQ, s.eq);
+    theremin_set_param(gEngine, THEREMIN_PARAM_COMPRESSOR, s.comp);
+    theremin_set_param(gEngine, THEREMIN_PARAM_HARMONY, s.harmony);
+    theremin_set_param(gEngine, THEREMIN_PARAM_VOCODER, s.vocoder);
+    theremin_set_param(gEngine, THEREMIN_PARAM_DELAY, s.delay);
+    theremin_set_param(gEngine, THEREMIN_PARAM_ADAPTIVE_SMOOTHING, s.adaptive);
+    theremin_set_param(gEngine, THEREMIN_PARAM_CHORD_MODE, float(s.chord));
+    theremin_set_param(gEngine, THEREMIN_PARAM_MASTER_DB, s.masterDb);
+    for (int b = 0; b < kEqBands; ++b) {
+        const EqBand& e = gConfig.eq[b];
+        theremin_set_eq_band(gEngine, b, int(e.type), e.hz, e.gainDb, e.q, e.enabled);
+    }
+}
+
+static bool Push(int type, float x, float y) {
+    theremin_event e;
+    e.time = NowSeconds();
+    e.x = x;
+    e.y = y;
+    e.type = type;
+    const bool ok = theremin_push_event(gEngine, &e) == THEREMIN_OK;
+    ++(ok ? gState.pushed : gState.dropped);
+    return ok;
+}
+
+static void LoadConfig() {
+    config_defaults(gConfig);
+    FILE* f = fopen(gOptions.configFile.c_str(), "rb");
+    if (!f) return; // the defaults
+    std::string text;
+    char buf[4096];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0; ) text.append(buf, n);
+    fclose(f);
+    AppConfig parsed;
+    int line = 0;
+    if (config_parse(text.data(), text.size(), parsed, &line)) gConfig = parsed;
+    else fprintf(stderr, "config: %s line %d not understood, using the defaults\n", gOptions.configFile.c_str(), line);
+}
+
+// ------------------------------
+// Audio thread: ALSA, or a real-time null sink
+// ------------------------------
+
+struct AudioState {
+    std::atomic<bool>  running{ false };
+    std::atomic<float> rmsDb{ -120.0f };   // output level for the meter
+    std::atomic<uint32_t> xruns{ 0 };
+    snd_pcm_t*  pcm = nullptr;
+    std::thread thread;
+};
+static AudioState gAudio;
+
+static void MeterBlock(const float* out, uint32_t frames) {
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < 2 * frames; ++i) sum += out[i] * out[i];
+    const float ms = sum / float(2 * frames);
+    gAudio.rmsDb.store(ms > 1e-12f ? 10.0f * log10f(ms) : -120.0f, std::memory_order_relaxed);
+}
+
+static void AudioThreadMain() {
+    // Real-time priority when the user may have it (audio group, rtkit)
+    sched_param sp{};
+    sp.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+
+    float out[2 * kBlockFrames];
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    const long blockNs = long(1e9 * kBlockFrames / kSampleRate);
+    while (gAudio.running.load()) {
+        theremin_process(gEngine, out, kBlockFrames, 2);
+        MeterBlock(out, kBlockFrames);
+        if (!gAudio.pcm) {
+            // Null sink: keep real time so input and drawing behave as live
+            next.tv_nsec += blockNs;
+            if (next.tv_nsec >= 1000000000L) { next.tv_nsec -= 1000000000L; ++next.tv_sec; }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+            continue;
+        }
+        for (snd_pcm_uframes_t done = 0; done < kBlockFrames; ) {
+            const snd_pcm_sframes_t n = snd_pcm_writei(gAudio.pcm, out + 2 * done, kBlockFrames - done);
+            if (n >= 0) { done += snd_pcm_uframes_t(n); continue; }
+            gAudio.xruns.fetch_add(1);
+            if (snd_pcm_recover(gAudio.pcm, int(n), 1) < 0) { gAudio.running.store(false); break; }
+        }
+    }
+}
+
+static bool OpenAudio() {
+    if (!gOptions.nullAudio) {
+        const unsigned latencyUs = unsigned(gConfig.latencyMs * 1000.0f);
+        if (snd_pcm_open(&gAudio.pcm, "default", SND_PCM_STREAM_PLAYBACK, 0) < 0 ||
+            snd_pcm_set_params(gAudio.pcm, SND_PCM_FORMAT_FLOAT_LE, SND_PCM_ACCESS_RW_INTERLEAVED, 2,
+                unsigned(kSampleRate), 1, latencyUs) < 0) {
+            fprintf(stderr, "audio: no ALSA output, rendering into a null sink\n");
+            if (gAudio.pcm) snd_pcm_close(gAudio.pcm);
+            gAudio.pcm = nullptr;
+        }
+    }
+    gEngine = theremin_create(kSampleRate);
+    if (!gEngine) return false;
+    SendState();
+    gAudio.running.store(true);
+    gAudio.thread = std::thread(AudioThreadMain);
+    return true;
+}
+
+static void CloseAudio() {
+    gAudio.running.store(false);
+    if (gAudio.thread.joinable()) gAudio.thread.join();
+    if (gAudio.pcm) {
+        snd_pcm_drain(gAudio.pcm);
+        snd_pcm_close(gAudio.pcm);
+        gAudio.pcm = nullptr;
+    }
+    theremin_destroy(gEngine);
+    gEngine = nullptr;
+}
+
+// ------------------------------
+// Visuals: software drawing into a shared-memory XImage
+// ------------------------------
+//
+// The same scene as the Win32 canvas: pitch grid, marker, level meter and
+// two text lines. Fills write the pixels directly; only the boxes that
+// changed are sent, with XShmPutImage when the server shares memory with
+// us (local displays, Xvfb) and XPutImage otherwise.
+
+static constexpr int kTextHeight = 44;
+static constexpr int kMarkerSize = 9;
+static constexpr uint32_t kColorBack = 0x101418;
+static constexpr uint32_t kColorOctave = 0x3a4250;
+static constexpr uint32_t kColorSemitone = 0x1c222a;
+static constexpr uint32_t kColorMarker = 0xffc040;
+static constexpr uint32_t kColorMuted = 0x707070;
+static constexpr uint32_t kColorLevel = 0x40c070;
+static constexpr uint32_t kColorLevelHot = 0xe04040; // RMS above -6 dBFS
+static constexpr double   kFramePeriod = 1.0 / 60.0;
+static constexpr int      kMaxBoxes = 8;
+
+struct Box { int x0, y0, x1, y1; };
+
+static inline bool box_empty(const Box& b) { return b.x1 <= b.x0 || b.y1 <= b.y0; }
+static inline bool box_equal(const Box& a, const Box& b) {
+    return a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
+}
+static inline Box box_intersect(const Box& a, const Box& b) {
+    return Box{ std::max(a.x0, b.x0), std::max(a.y0, b.y0), std::min(a.x1, b.x1), std::min(a.y1, b.y1) };
+}
+static inline Box box_union(const Box& a, const Box& b) {
+    return Box{ std::min(a.x0, b.x0), std::min(a.y0, b.y0), std::max(a.x1, b.x1), std::max(a.y1, b.y1) };
+}
+
+struct XUi {
+    Display*  dpy = nullptr;
+    Window    win = 0;
+    GC        gc = nullptr;
+    Visual*   visual = nullptr;
+    int       depth = 0;
+    Atom      wmDelete = 0;
+    int       xiOpcode = -1;
+    XImage*   image = nullptr;
+    XShmSegmentInfo shm{};
+    bool      useShm = false;
+    uint32_t* px = nullptr;        // 0x00RRGGBB, rows top to bottom
+    int       w = 0, h = 0;
+    Box       marker{}, level{};
+    Box       dirty[kMaxBoxes];
+    int       ndirty = 0;
+    std::string text[2];
+    double    textTime = 0.0;
+    float     intervalMs = 0.0f;   // smoothed frame-to-frame interval
+    float     drawUs = 0.0f;       // smoothed CPU time per frame (draw + put)
+    uint32_t  frames = 0, late = 0;
+    double    lastFrame = 0.0;
+};
+static XUi gUi;
+
+static void AddDirty(const Box& b) {
+    XUi& s = gUi;
+    if (box_empty(b)) return;
+    for (int i = 0; i < s.ndirty; ++i) {
+        if (!box_empty(box_intersect(s.dirty[i], b))) { s.dirty[i] = box_union(s.dirty[i], b); return; }
+    }
+    if (s.ndirty < kMaxBoxes) s.dirty[s.ndirty++] = b;
+    else s.dirty[s.ndirty - 1] = box_union(s.dirty[s.ndirty - 1], b);
+}
+
+// Solid fill, clipped to the image, four pixels at a time
+static void Fill(const Box& box, uint32_t color) {
+    XUi& s = gUi;
+    const Box k = box_intersect(box, Box{ 0, 0, s.w, s.h });
+    if (box_empty(k)) return;
+    const __m128i v = _mm_set1_epi32(int(color));
+    for (int y = k.y0; y < k.y1; ++y) {
+        uint32_t* p = s.px + size_t(y) * s.w + k.x0;
+        uint32_t* end = s.px + size_t(y) * s.w + k.x1;
+        while (p < end && (reinterpret_cast<uintptr_t>(p) & 15)) *p++ = color;
+        for (; p + 4 <= end; p += 4) _mm_store_si128(reinterpret_cast<__m128i*>(p), v);
+        while (p < end) *p++ = color;
+    }
+}
+
+static void ReleaseImage() {
+    XUi& s = gUi;
+    if (!s.image) return;
+    if (s.useShm) {
+        XShmDetach(s.dpy, &s.shm);
+        s.image->data = nullptr; // not ours to free
+        XDestroyImage(s.image);
+        shmdt(s.shm.shmaddr);
+    } else {
+        XDestroyImage(s.image); // frees px too
+    }
+    s.image = nullptr;
+    s.px = nullptr;
+    s.w = s.h = 0;
+}
+
+// (Re)create at the window size: shared memory when the server offers it
+static bool CreateImage(int w, int h) {
+    XUi& s = gUi;
+    ReleaseImage();
+    if (w <= 0 || h <= 0) return false;
+    s.useShm = XShmQueryExtension(s.dpy);
+    if (s.useShm) {
+        s.image = XShmCreateImage(s.dpy, s.visual, unsigned(s.depth), ZPixmap, nullptr, &s.shm, unsigned(w), unsigned(h));
+        if (s.image) s.shm.shmid = shmget(IPC_PRIVATE, size_t(s.image->bytes_per_line) * h, IPC_CREAT | 0600);
+        if (s.image && s.shm.shmid >= 0) {
+            s.shm.shmaddr = s.image->data = static_cast<char*>(shmat(s.shm.shmid, nullptr, 0));
+            s.shm.readOnly = False;
+            const bool attached = s.shm.shmaddr != reinterpret_cast<char*>(-1) && XShmAttach(s.dpy, &s.shm);
+            XSync(s.dpy, False);
+            shmctl(s.shm.shmid, IPC_RMID, nullptr); // freed once both sides detach
+            if (!attached) {
+                if (s.shm.shmaddr != reinterpret_cast<char*>(-1)) shmdt(s.shm.shmaddr);
+                s.image->data = nullptr;
+                XDestroyImage(s.image);
+                s.image = nullptr;
+            }
+        } else if (s.image) {
+            XDestroyImage(s.image);
+            s.image = nullptr;
+        }
+        s.useShm = s.image != nullptr;
+    }
+    if (!s.image) {
+        char* data = static_cast<char*>(malloc(size_t(w) * h * 4));
+        s.image = data ? XCreateImage(s.dpy, s.visual, unsigned(s.depth), ZPixmap, 0, data, unsigned(w), unsigned(h), 32, 0) : nullptr;
+        if (!s.image) { free(data); return false; }
+    }
+    s.px = reinterpret_cast<uint32_t*>(s.image->data);
+    s.w = w;
+    s.h = h;
+    return true;
+}
+
+static Box MarkerBox() {
+    const XUi& s = gUi;
+    const int x = int(gState.x * s.w), y = int(gState.y * s.h);
+    return Box{ x - kMarkerSize / 2, y - kMarkerSize / 2, x + kMarkerSize / 2 + 1, y + kMarkerSize / 2 + 1 };
+}
+
+// Output RMS, -60..0 dBFS, up the right edge
+static Box LevelBox() {
+    const XUi& s = gUi;
+    const float k = std::max(0.0f, std::min(1.0f, (gAudio.rmsDb.load(std::memory_order_relaxed) + 60.0f) / 60.0f));
+    const int top = kTextHeight + 8, bottom = s.h - 8;
+    return Box{ s.w - 18, bottom - int(k * float(std::max(bottom - top, 0))), s.w - 8, bottom };
+}
+
+// Returns true when either line changed
+static bool UpdateText() {
+    XUi& s = gUi;
+    const FrontState& st = gState;
+    static const char* const kChordNames[] = { "off", "chord", "arp" };
+    char line[2][192];
+    snprintf(line[0], sizeof(line[0]), "mode %d   eq %s  comp %s  harmony %s  vocoder %s  delay %s   chord %s   master %+.0f dB%s%s",
+        st.mode, st.eq ? "on" : "off", st.comp ? "on" : "off", st.harmony ? "on" : "off", st.vocoder ? "on" : "off",
+        st.delay ? "on" : "off", kChordNames[st.chord], st.masterDb, st.mute ? "   MUTE" : "", st.raw ? "   RAW" : "");
+    snprintf(line[1], sizeof(line[1]), "frame %4.1f ms (%u late)   draw %5.0f us %s   audio %s (%u xruns)   input sent %u dropped %u",
+        s.intervalMs, s.late, s.drawUs, s.useShm ? "shm" : "put", gAudio.pcm ? "alsa" : "null", gAudio.xruns.load(),
+        st.pushed, st.dropped);
+    bool changed = false;
+    for (int i = 0; i < 2; ++i) {
+        if (s.text[i] != line[i]) { s.text[i] = line[i]; changed = true; }
+    }
+    return changed;
+}
+
+// Repaint everything that intersects `area` into the image
+static void DrawScene(const Box& area) {
+    XUi& s = gUi;
+    const Box r = box_intersect(area, Box{ 0, 0, s.w, s.h });
+    if (box_empty(r)) return;
+    Fill(r, kColorBack);
+
+    // Pitch grid: every semitone of A from 27.5 Hz, octaves brighter
+    const EngineConfig& cfg = kEngineDefaults; // what the library plays
+    for (int k = 0; ; ++k) {
+        const float hz = 27.5f * powf(2.0f, k / 12.0f);
+        if (hz > cfg.maxHz) break;
+        if (hz < cfg.minHz) continue;
+        const int x = int(map_hz_to_nx(cfg, hz) * s.w);
+        Fill(box_intersect(Box{ x, kTextHeight, x + 1, s.h }, r), k % 12 ? kColorSemitone : kColorOctave);
+    }
+    const bool hot = gAudio.rmsDb.load(std::memory_order_relaxed) > -6.0f;
+    Fill(box_intersect(s.level, r), hot ? kColorLevelHot : kColorLevel);
+    Fill(box_intersect(s.marker, r), gState.mute ? kColorMuted : kColorMarker);
+}
+
+// Copy a box to the window; the text band gets its lines drawn over it
+static void Present(const Box& box) {
+    XUi& s = gUi;
+    const Box k = box_intersect(box, Box{ 0, 0, s.w, s.h });
+    if (box_empty(k)) return;
+    const unsigned w = unsigned(k.x1 - k.x0), h = unsigned(k.y1 - k.y0);
+    if (s.useShm) XShmPutImage(s.dpy, s.win, s.gc, s.image, k.x0, k.y0, k.x0, k.y0, w, h, False);
+    else XPutImage(s.dpy, s.win, s.gc, s.image, k.x0, k.y0, k.x0, k.y0, w, h);
+    if (k.y0 < kTextHeight) {
+        XSetForeground(s.dpy, s.gc, 0xc8cdd7);
+        for (int i = 0; i < 2; ++i)
+            XDrawString(s.dpy, s.win, s.gc, 8, 19 + 18 * i, s.text[i].c_str(), int(s.text[i].size()));
+    }
+}
+
+static void Resize(int w, int h) {
+    XUi& s = gUi;
+    if (w == s.w && h == s.h && s.px) return;
+    if (!CreateImage(w, h)) return;
+    s.marker = MarkerBox();
+    s.level = LevelBox();
+    s.ndirty = 0;
+    UpdateText();
+    DrawScene(Box{ 0, 0, s.w, s.h });
+    AddDirty(Box{ 0, 0, s.w, s.h });
+}
+
+static void DrawFrame(double start) {
+    XUi& s = gUi;
+    if (!s.px) return;
+    const Box marker = MarkerBox();
+    if (!box_equal(marker, s.marker)) {
+        AddDirty(s.marker);
+        AddDirty(marker);
+        s.marker = marker;
+    }
+    const Box level = LevelBox();
+    if (!box_equal(level, s.level)) {
+        AddDirty(box_union(level, s.level));
+        s.level = level;
+    }
+    if (start - s.textTime >= 0.2) {
+        if (UpdateText()) AddDirty(Box{ 0, 0, s.w, kTextHeight });
+        s.textTime = start;
+    }
+    if (s.ndirty) {
+        for (int i = 0; i < s.ndirty; ++i) DrawScene(s.dirty[i]);
+        for (int i = 0; i < s.ndirty; ++i) Present(s.dirty[i]);
+        s.ndirty = 0;
+        XSync(s.dpy, False); // the server has read the pixels before we touch them again
+    }
+    if (s.lastFrame > 0.0) {
+        const float ms = float((start - s.lastFrame) * 1000.0);
+        s.intervalMs += 0.05f * (ms - s.intervalMs);
+        if (ms > 1500.0 * kFramePeriod) ++s.late;
+    }
+    s.lastFrame = start;
+    s.drawUs += 0.05f * (float((NowSeconds() - start) * 1e6) - s.drawUs);
+    ++s.frames;
+}
+
+// ------------------------------
+// Input: XInput2 pointer, core keyboard
+// ------------------------------
+//
+// XI_Motion carries the pointer position with subpixel precision. With raw
+// input on, XI_RawMotion from the root window gives unaccelerated device
+// counts instead, one event per report, integrated here into a position
+// the way the Win32 raw mouse mode does.
+
+static constexpr float kRawCountScale = 1.0f; // device counts per window pixel
+
+static void SelectRawMotion(bool on) {
+    XUi& s = gUi;
+    unsigned char bits[XIMaskLen(XI_LASTEVENT)] = {};
+    if (on) XISetMask(bits, XI_RawMotion);
+    XIEventMask mask;
+    mask.deviceid = XIAllMasterDevices;
+    mask.mask_len = sizeof(bits);
+    mask.mask = bits;
+    XISelectEvents(s.dpy, DefaultRootWindow(s.dpy), &mask, 1);
+    gState.raw = on;
+}
+
+static void OnMotion(double x, double y, bool shift) {
+    XUi& s = gUi;
+    if (!gState.raw && s.w > 0 && s.h > 0) {
+        gState.x = std::max(0.0f, std::min(1.0f, float(x / s.w)));
+        gState.y = std::max(0.0f, std::min(1.0f, float(y / s.h)));
+        Push(THEREMIN_EVENT_POSITION, float(x / s.w), float(y / s.h));
+    }
+    // Shift increases vibrato depth; pushed only when it changes
+    const float depth = shift ? 1.0f : 0.0f;
+    if (depth != gState.vibrato && Push(THEREMIN_EVENT_VIBRATO, depth, 0.0f))
+        gState.vibrato = depth; // a dropped one is retried on the next move
+}
+
+static void OnRawMotion(const XIRawEvent* raw) {
+    XUi& s = gUi;
+    if (!gState.raw || s.w <= 0 || s.h <= 0) return;
+    // raw_values holds one entry per set bit in the mask, in axis order
+    double d[2] = { 0.0, 0.0 };
+    const double* v = raw->raw_values;
+    for (int i = 0; i < raw->valuators.mask_len * 8; ++i) {
+        if (!XIMaskIsSet(raw->valuators.mask, i)) continue;
+        if (i < 2) d[i] = *v;
+        ++v;
+    }
+    if (d[0] == 0.0 && d[1] == 0.0) return;
+    const float dx = float(d[0]) * kRawCountScale / float(s.w), dy = float(d[1]) * kRawCountScale / float(s.h);
+    gState.x = std::max(0.0f, std::min(1.0f, gState.x + dx));
+    gState.y = std::max(0.0f, std::min(1.0f, gState.y + dy));
+    Push(THEREMIN_EVENT_MOTION, dx, dy);
+}
+
+// X keysym -> the Windows virtual-key code the bindings are keyed by
+static int VirtualKey(KeySym k) {
+    if (k >= XK_a && k <= XK_z) return int('A' + (k - XK_a));
+    if (k >= XK_A && k <= XK_Z) return int(k);
+    if (k >= XK_0 && k <= XK_9) return int(k);
+    if (k >= XK_F1 && k <= XK_F12) return int(0x70 + (k - XK_F1));
+    switch (k) {
+    case XK_space:       return 0x20;
+    case XK_Return:      return 0x0D;
+    case XK_BackSpace:   return 0x08;
+    case XK_Delete:      return 0x2E;
+    case XK_Escape:      return 0x1B;
+    case XK_plus:
+    case XK_equal:       return 0xBB;
+    case XK_minus:       return 0xBD;
+    case XK_KP_Add:      return 0x6B;
+    case XK_KP_Subtract: return 0x6D;
+    default:             return 0;
+    }
+}
+
+// Returns false on Quit. Actions with no C API counterpart (recorder,
+// loudness reset, auto gain, prediction, harmonizer quality) are ignored.
+static bool OnKey(KeySym sym) {
+    FrontState& s = gState;
+    const int vk = VirtualKey(sym);
+    switch (vk ? gConfig.keys[vk] : KeyAction::None) {
+    case KeyAction::Mode1: s.mode = 1; break;
+    case KeyAction::Mode2: s.mode = 2; break;
+    case KeyAction::Mode3: s.mode = 3; break;
+    case KeyAction::Mode4: s.mode = 4; break;
+    case KeyAction::Eq:       s.eq = !s.eq; break;
+    case KeyAction::Comp:     s.comp = !s.comp; break;
+    case KeyAction::Harmony:  s.harmony = !s.harmony; break;
+    case KeyAction::Vocoder:  s.vocoder = !s.vocoder; break;
+    case KeyAction::Delay:    s.delay = !s.delay; break;
+    case KeyAction::Adaptive: s.adaptive = !s.adaptive; break;
+    case KeyAction::MasterUp:   s.masterDb = std::min(kMasterMaxDb, s.masterDb + 1.0f); break;
+    case KeyAction::MasterDown: s.masterDb = std::max(kMasterMinDb, s.masterDb - 1.0f); break;
+    case KeyAction::Chord: s.chord = (s.chord + 1) % 3; break; // chord, arpeggio, off
+    case KeyAction::Mute:  s.mute = !s.mute; break;
+    case KeyAction::RawInput: SelectRawMotion(!s.raw); break;
+    case KeyAction::Latch:      Push(THEREMIN_EVENT_LATCH, 0.0f, 0.0f); return true;
+    case KeyAction::Release:    Push(THEREMIN_EVENT_RELEASE, 0.0f, 0.0f); return true;
+    case KeyAction::ReleaseAll: Push(THEREMIN_EVENT_RELEASE, 1.0f, 0.0f); return true;
+    case KeyAction::Quit: return false;
+    default: return true;
+    }
+    SendState();
+    gUi.textTime = 0.0; // show it on the next frame
+    return true;
+}
+
+// ------------------------------
+// Window and main loop
+// ------------------------------
+
+static bool OpenWindow() {
+    XUi& s = gUi;
+    s.dpy = XOpenDisplay(nullptr);
+    if (!s.dpy) { fprintf(stderr, "x11: cannot open display\n"); return false; }
+    int event = 0, error = 0, major = 2, minor = 0;
+    if (!XQueryExtension(s.dpy, "XInputExtension", &s.xiOpcode, &event, &error) ||
+        XIQueryVersion(s.dpy, &major, &minor) != Success) {
+        fprintf(stderr, "x11: the server has no XInput 2\n");
+        return false;
+    }
+    const int scr = DefaultScreen(s.dpy);
+    s.visual = DefaultVisual(s.dpy, scr);
+    s.depth = DefaultDepth(s.dpy, scr);
+    if ((s.depth != 24 && s.depth != 32) || s.visual->red_mask != 0xff0000 || s.visual->blue_mask != 0xff) {
+        fprintf(stderr, "x11: needs a 24-bit RGB visual\n");
+        return false;
+    }
+    s.win = XCreateSimpleWindow(s.dpy, RootWindow(s.dpy, scr), 0, 0, 1024, 600, 0, 0, kColorBack);
+    XStoreName(s.dpy, s.win, "Theremin");
+    XSelectInput(s.dpy, s.win, ExposureMask | StructureNotifyMask | KeyPressMask);
+    s.wmDelete = XInternAtom(s.dpy, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(s.dpy, s.win, &s.wmDelete, 1);
+
+    unsigned char bits[XIMaskLen(XI_LASTEVENT)] = {};
+    XISetMask(bits, XI_Motion);
+    XIEventMask mask;
+    mask.deviceid = XIAllMasterDevices;
+    mask.mask_len = sizeof(bits);
+    mask.mask = bits;
+    XISelectEvents(s.dpy, s.win, &mask, 1);
+
+    s.gc = XCreateGC(s.dpy, s.win, 0, nullptr);
+    XMapWindow(s.dpy, s.win);
+    return true;
+}
+
+static void CloseWindow() {
+    XUi& s = gUi;
+    if (!s.dpy) return;
+    ReleaseImage();
+    if (s.gc) XFreeGC(s.dpy, s.gc);
+    if (s.win) XDestroyWindow(s.dpy, s.win);
+    XCloseDisplay(s.dpy);
+    s.dpy = nullptr;
+}
+
+// Returns false when the window was closed or Quit pressed
+static bool HandleEvent(XEvent& ev) {
+    XUi& s = gUi;
+    switch (ev.type) {
+    case Expose:
+        if (ev.xexpose.count == 0) AddDirty(Box{ 0, 0, s.w, s.h });
+        break;
+    case ConfigureNotify:
+        Resize(ev.xconfigure.width, ev.xconfigure.height);
+        break;
+    case KeyPress:
+        return OnKey(XLookupKeysym(&ev.xkey, 0));
+    case ClientMessage:
+        return Atom(ev.xclient.data.l[0]) != s.wmDelete;
+    case GenericEvent:
+        if (ev.xcookie.extension == s.xiOpcode && XGetEventData(s.dpy, &ev.xcookie)) {
+            if (ev.xcookie.evtype == XI_Motion) {
+                const XIDeviceEvent* d = static_cast<const XIDeviceEvent*>(ev.xcookie.data);
+                OnMotion(d->event_x, d->event_y, (d->mods.effective & ShiftMask) != 0);
+            } else if (ev.xcookie.evtype == XI_RawMotion) {
+                OnRawMotion(static_cast<const XIRawEvent*>(ev.xcookie.data));
+            }
+            XFreeEventData(s.dpy, &ev.xcookie);
+        }
+        break;
+    }
+    return true;
+}
+
+static void ParseCommandLine(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--null-audio") gOptions.nullAudio = true;
+        else if (a == "--config" && i + 1 < argc) gOptions.configFile = argv[++i];
+        else if (a == "--quit-after" && i + 1 < argc) gOptions.quitAfter = atof(argv[++i]);
+        else fprintf(stderr, "unknown option %s\n", a.c_str());
+    }
+}
+
+int main(int argc, char** argv) {
+    ParseCommandLine(argc, argv);
+    LoadConfig();
+    if (!OpenWindow()) { CloseWindow(); return 1; }
+    if (!OpenAudio()) { fprintf(stderr, "audio: engine not created\n"); CloseWindow(); return 1; }
+
+    const double begin = NowSeconds();
+    double nextFrame = begin;
+    const int fd = ConnectionNumber(gUi.dpy);
+    bool running = true;
+    while (running && gAudio.running.load()) {
+        // Sleep on the X connection until the next frame is due
+        const double wait = nextFrame - NowSeconds();
+        if (wait > 0.0 && !XPending(gUi.dpy)) {
+            pollfd p{ fd, POLLIN, 0 };
+            poll(&p, 1, int(wait * 1000.0) + 1);
+        }
+        while (running && XPending(gUi.dpy)) {
+            XEvent ev;
+            XNextEvent(gUi.dpy, &ev);
+            running = HandleEvent(ev);
+        }
+        const double now = NowSeconds();
+        if (now >= nextFrame) {
+            DrawFrame(now);
+            nextFrame += kFramePeriod;
+            if (nextFrame < now) nextFrame = now + kFramePeriod; // fell behind: no catch-up burst
+        }
+        if (gOptions.quitAfter > 0.0 && now - begin >= gOptions.quitAfter) running = false;
+    }
+
+    const XUi& s = gUi;
+    printf("frames %u (%u late), draw %.0f us, input sent %u dropped %u, xruns %u\n",
+        s.frames, s.late, s.drawUs, gState.pushed, gState.dropped, gAudio.xruns.load());
+    CloseAudio();
+    CloseWindow();
+    return 0;
+}
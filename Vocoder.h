@@ -0,0 +1,208 @@
+#pragma once
+#include <xmmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "SimdMath.h"
+
+// ------------------------------
+// Channel vocoder: SIMD filter bank, bands across lanes
+// ------------------------------
+//
+// The theremin voice is the carrier; the modulator is live input or a looped
+// WAV stand-in. Each SSE register holds four adjacent bands, so a sample
+// costs bands/4 vector iterations for both banks plus the followers.
+
+static constexpr int      kVocMaxBands = 64;
+static constexpr int      kVocGroups = kVocMaxBands / 4;
+static constexpr uint32_t kModRing = 16384;   // modulator FIFO (power of two)
+static constexpr uint32_t kModMaxFill = 2048; // drop oldest beyond this (~40 ms)
+
+struct VocoderParams {
+    std::atomic<bool>  enabled{ false };
+    std::atomic<int>   bands{ 32 };         // 16..64, multiple of 4
+    std::atomic<float> lowHz{ 100.0f };     // band centres are log-spaced
+    std::atomic<float> highHz{ 8000.0f };
+    std::atomic<float> attackMs{ 2.0f };    // envelope followers
+    std::atomic<float> releaseMs{ 30.0f };
+    std::atomic<float> noise{ 0.05f };      // carrier hiss for unvoiced sounds
+    std::atomic<float> level{ 8.0f };       // output makeup
+    std::atomic<float> mix{ 1.0f };         // 0 = dry voice, 1 = vocoded
+};
+
+struct VocoderState {
+    // Band-pass biquads (b1 = 0, b2 = -b0), shared by both banks
+    __m128 b0[kVocGroups], a1[kVocGroups], a2[kVocGroups];
+    __m128 mz1[kVocGroups], mz2[kVocGroups]; // modulator bank
+    __m128 cz1[kVocGroups], cz2[kVocGroups]; // carrier bank
+    __m128 env[kVocGroups];
+    int    bands = 0;
+    float  lowHz = 0.0f, highHz = 0.0f;
+    uint32_t noiseSeed = 0x9E3779B9u;
+};
+
+// A decoded modulator file: mono, already at the output rate, never empty
+struct ModulatorClip {
+    std::vector<float> samples;
+};
+
+// Modulator feed: live capture FIFO with a looped file as stand-in.
+// Only the audio thread touches it, except `clip`, which other threads
+// swap through the engine (the old clip is retired, see Epoch.h).
+struct ModulatorFeed {
+    std::atomic<ModulatorClip*> clip{ nullptr };
+    const ModulatorClip* playing = nullptr;  // last clip pulled, compared only
+    size_t             filePos = 0;
+    std::vector<float> ring;
+    uint32_t           w = 0, r = 0;
+    bool               live = false;
+    double             resamplePos = 0.0; // capture -> output rate
+    float              lastIn = 0.0f;
+
+    ~ModulatorFeed() { delete clip.load(); }
+};
+
+static inline void vocoder_reset(VocoderState& s) {
+    const __m128 zero = _mm_setzero_ps();
+    for (int g = 0; g < kVocGroups; ++g) {
+        s.b0[g] = zero; s.a1[g] = zero; s.a2[g] = zero;
+        s.mz1[g] = zero; s.mz2[g] = zero; s.cz1[g] = zero; s.cz2[g] = zero;
+        s.env[g] = zero;
+    }
+    s.bands = 0;
+}
+
+static inline void vocoder_design(VocoderState& s, int bands, float lowHz, float highHz, float sampleRate) {
+    alignas(16) float b0[kVocMaxBands], a1[kVocMaxBands], a2[kVocMaxBands];
+    highHz = std::fmin(highHz, 0.45f * sampleRate);
+    const float step = powf(highHz / lowHz, 1.0f / float(bands - 1));
+    // Neighbouring bands cross around -3 dB
+    const float q = sqrtf(step) / (step - 1.0f);
+    for (int k = 0; k < bands; ++k) {
+        const float hz = lowHz * powf(step, float(k));
+        const float w0 = 6.28318530717958647692f * hz / sampleRate;
+        const float alpha = sinf(w0) / (2.0f * q);
+        const float inv = 1.0f / (1.0f + alpha);
+        b0[k] = alpha * inv;
+        a1[k] = -2.0f * cosf(w0) * inv;
+        a2[k] = (1.0f - alpha) * inv;
+    }
+    for (int g = 0; g < bands / 4; ++g) {
+        s.b0[g] = _mm_load_ps(b0 + 4 * g);
+        s.a1[g] = _mm_load_ps(a1 + 4 * g);
+        s.a2[g] = _mm_load_ps(a2 + 4 * g);
+    }
+    s.bands = bands;
+    s.lowHz = lowHz;
+    s.highHz = highHz;
+}
+
+// Replace `voice` (mono carrier) with the vocoded signal, reading `frames`
+// modulator samples from `mod`.
+static inline void vocoder_process(VocoderState& s, const VocoderParams& p, float* voice,
+                                   const float* mod, uint32_t frames, float sampleRate) {
+    int bands = p.bands.load(std::memory_order_relaxed);
+    bands = std::max(16, std::min(kVocMaxBands, bands & ~3));
+    const float lowHz = std::fmax(20.0f, p.lowHz.load(std::memory_order_relaxed));
+    const float highHz = std::fmax(lowHz * 2.0f, p.highHz.load(std::memory_order_relaxed));
+    if (bands != s.bands || lowHz != s.lowHz || highHz != s.highHz)
+        vocoder_design(s, bands, lowHz, highHz, sampleRate);
+
+    const float atk = 1.0f - expf(-1.0f / (std::fmax(0.1f, p.attackMs.load(std::memory_order_relaxed)) * 0.001f * sampleRate));
+    const float rel = 1.0f - expf(-1.0f / (std::fmax(1.0f, p.releaseMs.load(std::memory_order_relaxed)) * 0.001f * sampleRate));
+    const float noise = p.noise.load(std::memory_order_relaxed);
+    const float level = p.level.load(std::memory_order_relaxed);
+    const float mix = p.mix.load(std::memory_order_relaxed);
+    const __m128 vAtk = _mm_set1_ps(atk), vRel = _mm_set1_ps(rel);
+    const int groups = bands / 4;
+
+    for (uint32_t i = 0; i < frames; ++i) {
+        s.noiseSeed = 1664525u * s.noiseSeed + 1013904223u;
+        const float hiss = noise * ((s.noiseSeed >> 8) * (2.0f / 16777216.0f) - 1.0f);
+        const __m128 m = _mm_set1_ps(mod[i]);
+        const __m128 c = _mm_set1_ps(voice[i] + hiss);
+        __m128 acc = _mm_setzero_ps();
+
+        for (int g = 0; g < groups; ++g) {
+            // Modulator band -> envelope
+            const __m128 bm = _mm_mul_ps(s.b0[g], m);
+            const __m128 ym = _mm_add_ps(bm, s.mz1[g]);
+            s.mz1[g] = _mm_sub_ps(s.mz2[g], _mm_mul_ps(s.a1[g], ym));
+            s.mz2[g] = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(bm, _mm_mul_ps(s.a2[g], ym)));
+
+            const __m128 r = abs_ps(ym);
+            const __m128 up = _mm_cmpgt_ps(r, s.env[g]);
+            const __m128 k = _mm_or_ps(_mm_and_ps(up, vAtk), _mm_andnot_ps(up, vRel));
+            s.env[g] = _mm_add_ps(s.env[g], _mm_mul_ps(k, _mm_sub_ps(r, s.env[g])));
+
+            // Carrier band, weighted by the envelope
+            const __m128 bc = _mm_mul_ps(s.b0[g], c);
+            const __m128 yc = _mm_add_ps(bc, s.cz1[g]);
+            s.cz1[g] = _mm_sub_ps(s.cz2[g], _mm_mul_ps(s.a1[g], yc));
+            s.cz2[g] = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(bc, _mm_mul_ps(s.a2[g], yc)));
+
+            acc = _mm_add_ps(acc, _mm_mul_ps(yc, s.env[g]));
+        }
+
+        // Horizontal sum of the four lanes
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(1, 1, 1, 1)));
+        const float wet = level * _mm_cvtss_f32(acc);
+        voice[i] += mix * (wet - voice[i]);
+    }
+}
+
+static inline void modulator_init(ModulatorFeed& f) {
+    f.ring.assign(kModRing, 0.0f);
+    f.w = f.r = 0;
+    f.filePos = 0;
+    f.resamplePos = 0.0;
+    f.lastIn = 0.0f;
+}
+
+// Push interleaved capture frames, downmixed to mono and linearly resampled
+// by `step` = captureRate / outputRate.
+static inline void modulator_push(ModulatorFeed& f, const float* in, uint32_t frames, int channels, double step) {
+    const uint32_t mask = kModRing - 1;
+    for (uint32_t i = 0; i < frames; ++i) {
+        float x = 0.0f;
+        if (in) { // null = silent packet
+            for (int c = 0; c < channels; ++c) x += in[i * channels + c];
+            x /= float(channels);
+        }
+        // Emit output samples that fall between lastIn and x
+        while (f.resamplePos < 1.0) {
+            const float t = float(f.resamplePos);
+            f.ring[f.w & mask] = f.lastIn + t * (x - f.lastIn);
+            ++f.w;
+            f.resamplePos += step;
+        }
+        f.resamplePos -= 1.0;
+        f.lastIn = x;
+    }
+    if (f.w - f.r > kModMaxFill) f.r = f.w - kModMaxFill / 2; // keep latency bounded
+    f.live = true;
+}
+
+static inline void modulator_pull(ModulatorFeed& f, float* out, uint32_t frames) {
+    if (f.live) {
+        const uint32_t mask = kModRing - 1;
+        for (uint32_t i = 0; i < frames; ++i)
+            out[i] = (f.r != f.w) ? f.ring[f.r++ & mask] : 0.0f;
+    } else if (const ModulatorClip* c = f.clip.load()) {
+        // A new clip starts from its top (a recycled address just wraps)
+        if (c != f.playing || f.filePos >= c->samples.size()) f.filePos = 0;
+        f.playing = c;
+        const float* x = c->samples.data();
+        const size_t n = c->samples.size();
+        for (uint32_t i = 0; i < frames; ++i) {
+            out[i] = x[f.filePos];
+            if (++f.filePos >= n) f.filePos = 0;
+        }
+    } else {
+        for (uint32_t i = 0; i < frames; ++i) out[i] = 0.0f;
+    }
+}
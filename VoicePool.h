@@ -0,0 +1,193 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+// ------------------------------
+// Voice pool: chord and arpeggio voices built on the played pitch
+// ------------------------------
+//
+// The hand picks a root. The pitch is quantised to the scale, and the
+// chord on that degree comes from a table built once at init. Chord tones
+// play on pool voices alongside the main voice, which plays the root. The
+// arpeggiator is one more pool voice, stepping through the same tones an
+// octave up in time with the delay tempo. Everything that depends on the
+// gesture is decided once per block; per sample there are only oscillators.
+
+static constexpr int   kScaleDegrees = 7;
+static constexpr int   kChordTones = 4;                 // root, third, fifth, octave
+static constexpr int   kChordVoices = kChordTones - 1;  // the root is the main voice
+static constexpr float kChordHysteresis = 0.2f;         // semitones past the midpoint to change root
+
+enum class ChordMode : int { Off = 0, Chord, Arp };
+
+struct ChordParams {
+    std::atomic<int>   mode{ int(ChordMode::Off) };
+    std::atomic<float> tonicHz{ 261.6256f };  // major scale on C4
+    std::atomic<float> level{ 0.6f };         // pool voices relative to the root
+    std::atomic<float> arpDivision{ 4.0f };   // steps per beat of the delay tempo
+    std::atomic<float> arpGate{ 0.7f };       // sounding fraction of a step (max 0.95)
+};
+
+struct PoolVoice {
+    float phase = 0.0f;
+    float hz = 0.0f;      // at the end of the last block
+    float level = 0.0f;
+};
+
+struct ChordState {
+    float     ratio[kScaleDegrees][kChordTones];  // chord on each degree, ratios to its root
+    int       scale[kScaleDegrees + 1];           // semitones above the tonic, plus the octave
+    PoolVoice tone[kChordVoices];
+    PoolVoice arp;
+    int       degree = 0;
+    float     rootSemis = 0.0f;   // semitones from the tonic
+    bool      held = false;       // a root has been chosen
+    uint32_t  arpPos = 0;         // samples into the current step
+    int       arpStep = 0;
+};
+
+static inline void chord_init(ChordState& s) {
+    static const int major[kScaleDegrees] = { 0, 2, 4, 5, 7, 9, 11 };
+    for (int d = 0; d < kScaleDegrees; ++d) {
+        s.scale[d] = major[d];
+        // Diatonic triad: stacked thirds within the scale, then the octave
+        for (int k = 0; k < 3; ++k) {
+            const int idx = d + 2 * k;
+            const int semis = major[idx % kScaleDegrees] + 12 * (idx / kScaleDegrees) - major[d];
+            s.ratio[d][k] = powf(2.0f, float(semis) / 12.0f);
+        }
+        s.ratio[d][3] = 2.0f;
+    }
+    s.scale[kScaleDegrees] = 12;
+    for (PoolVoice& v : s.tone) v = PoolVoice{};
+    s.arp = PoolVoice{};
+    s.degree = 0;
+    s.rootSemis = 0.0f;
+    s.held = false;
+    s.arpPos = 0;
+    s.arpStep = 0;
+}
+
+// Quantise `hz` to a scale note and make it the chord root. The current
+// root is kept until the pitch is clearly nearer its neighbour.
+static inline float chord_root(ChordState& s, float hz, float tonicHz) {
+    const float semis = 12.0f * log2f(std::fmax(hz, 1.0f) / tonicHz);
+    const float octave = floorf(semis / 12.0f);
+    const float within = semis - 12.0f * octave;
+    int best = 0;
+    for (int d = 1; d <= kScaleDegrees; ++d)
+        if (fabsf(within - float(s.scale[d])) < fabsf(within - float(s.scale[best]))) best = d;
+    const float nearest = 12.0f * octave + float(s.scale[best]);
+    if (!s.held || fabsf(semis - s.rootSemis) > fabsf(semis - nearest) + kChordHysteresis) {
+        s.rootSemis = nearest;
+        s.degree = best % kScaleDegrees;
+        s.held = true;
+    }
+    return tonicHz * powf(2.0f, s.rootSemis / 12.0f);
+}
+
+// ------------------------------
+// Drones: latched voices with frozen pitch and level
+// ------------------------------
+//
+// A latched voice never changes pitch, so it needs no slew, vibrato or
+// per-sample waveform maths. It replays one precomputed cycle of the mode's
+// waveform from a table, using a 32-bit fixed-point phase and linear
+// interpolation. Only fades in and out take the ramped path; a held drone
+// costs a table read and a multiply-add per sample.
+
+static constexpr int      kDroneVoices = 8;
+static constexpr int      kDroneTableBits = 11;
+static constexpr uint32_t kDroneTable = 1u << kDroneTableBits;  // samples per cycle
+static constexpr float    kDroneFadeMs = 20.0f;
+
+struct DroneVoice {
+    const float* table = nullptr;  // null = free
+    uint32_t phase = 0, inc = 0;   // cycle position, 32-bit fixed point
+    float    level = 0.0f;
+    float    target = 0.0f;        // frozen level, or 0 while releasing
+    float    held = 0.0f;          // frozen level (sets the fade rate)
+    uint32_t serial = 0;           // latch order
+};
+
+struct DroneBank {
+    float      table[4][kDroneTable + 1];  // one cycle per mode, plus a guard sample
+    DroneVoice voice[kDroneVoices];
+    uint32_t   serial = 0;
+    int        active = 0;
+};
+
+static inline void drone_reset(DroneBank& b) {
+    for (DroneVoice& v : b.voice) v = DroneVoice{};
+    b.serial = 0;
+    b.active = 0;
+}
+
+// Start a drone at `hz` and `level`, in phase with the live voice (`cycle`
+// 0..1) so the fade-in is smooth. Returns false when every slot is taken.
+static inline bool drone_latch(DroneBank& b, int mode, float hz, float level, float cycle, float sampleRate) {
+    for (DroneVoice& v : b.voice) {
+        if (v.table) continue;
+        v.table = b.table[std::max(1, std::min(4, mode)) - 1];
+        v.phase = uint32_t(double(cycle - floorf(cycle)) * 4294967296.0);
+        v.inc = uint32_t(double(hz) / sampleRate * 4294967296.0);
+        v.level = 0.0f;
+        v.target = v.held = level;
+        v.serial = ++b.serial;
+        ++b.active;
+        return true;
+    }
+    return false;
+}
+
+// Fade out the most recent drone, or all of them
+static inline void drone_release(DroneBank& b, bool all) {
+    DroneVoice* newest = nullptr;
+    for (DroneVoice& v : b.voice) {
+        if (!v.table || v.target == 0.0f) continue;
+        if (all) v.target = 0.0f;
+        else if (!newest || v.serial > newest->serial) newest = &v;
+    }
+    if (newest) newest->target = 0.0f;
+}
+
+// Add every drone into `out`
+static inline void drone_render(DroneBank& b, float* out, uint32_t frames, float sampleRate) {
+    const float fadeStep = 1.0f / (kDroneFadeMs * 0.001f * sampleRate);
+    const uint32_t shift = 32 - kDroneTableBits;
+    const float fracScale = 1.0f / float(1u << shift);
+    for (DroneVoice& v : b.voice) {
+        if (!v.table) continue;
+        const float* t = v.table;
+        uint32_t phase = v.phase;
+        if (v.level == v.target) {
+            // Held: static pitch and level
+            const float g = v.level;
+            for (uint32_t i = 0; i < frames; ++i) {
+                const uint32_t k = phase >> shift;
+                const float frac = float(int32_t(phase & ((1u << shift) - 1))) * fracScale;
+                out[i] += g * (t[k] + frac * (t[k + 1] - t[k]));
+                phase += v.inc;
+            }
+        } else {
+            // Fading toward the target, linear in amplitude
+            float g = v.level;
+            const float step = (v.target > g ? 1.0f : -1.0f) * fadeStep * v.held;
+            for (uint32_t i = 0; i < frames; ++i) {
+                g = step > 0.0f ? std::fmin(v.target, g + step) : std::fmax(v.target, g + step);
+                const uint32_t k = phase >> shift;
+                const float frac = float(int32_t(phase & ((1u << shift) - 1))) * fracScale;
+                out[i] += g * (t[k] + frac * (t[k + 1] - t[k]));
+                phase += v.inc;
+            }
+            v.level = g;
+            if (g == 0.0f && v.target == 0.0f) {
+                v.table = nullptr;
+                --b.active;
+            }
+        }
+        v.phase = phase;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// ------------------------------
+// Minimal RIFF/WAVE decoding and float32 header writing
+// ------------------------------
+
+static inline uint32_t wav_u32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+static inline uint16_t wav_u16(const uint8_t* p) { return uint16_t(p[0] | (p[1] << 8)); }
+
+// Decode PCM16/24/32 or float32 WAV bytes to mono float at `targetRate`
+// (linear resampling). Returns false for anything it doesn't understand.
+static inline bool wav_decode_mono(const uint8_t* data, size_t size, float targetRate, std::vector<float>& out) {
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) return false;
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    uint32_t rate = 0;
+    const uint8_t* pcm = nullptr;
+    size_t pcmBytes = 0;
+
+    for (size_t pos = 12; pos + 8 <= size; ) {
+        const uint32_t len = wav_u32(data + pos + 4);
+        const uint8_t* body = data + pos + 8;
+        if (len > size - pos - 8) break;
+        if (memcmp(data + pos, "fmt ", 4) == 0 && len >= 16) {
+            format = wav_u16(body);
+            channels = wav_u16(body + 2);
+            rate = wav_u32(body + 4);
+            bits = wav_u16(body + 14);
+            if (format == 0xFFFE && len >= 26) format = wav_u16(body + 24); // extensible subformat
+        } else if (memcmp(data + pos, "data", 4) == 0) {
+            pcm = body;
+            pcmBytes = len;
+        }
+        pos += 8 + len + (len & 1);
+    }
+
+    const bool isFloat = (format == 3 && bits == 32);
+    const bool isPcm = (format == 1 && (bits == 16 || bits == 24 || bits == 32));
+    if (!pcm || channels == 0 || rate == 0 || (!isFloat && !isPcm)) return false;
+
+    const size_t bytesPerSample = bits / 8;
+    const size_t frames = pcmBytes / (bytesPerSample * channels);
+    std::vector<float> mono(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        float acc = 0.0f;
+        for (uint16_t c = 0; c < channels; ++c) {
+            const uint8_t* s = pcm + (i * channels + c) * bytesPerSample;
+            float x;
+            if (isFloat) { memcpy(&x, s, 4); }
+            else if (bits == 16) x = int16_t(wav_u16(s)) / 32768.0f;
+            else if (bits == 24) x = int32_t((s[0] << 8) | (s[1] << 16) | (uint32_t(s[2]) << 24)) / 2147483648.0f;
+            else x = int32_t(wav_u32(s)) / 2147483648.0f;
+            acc += x;
+        }
+        mono[i] = acc / channels;
+    }
+
+    const double step = double(rate) / targetRate;
+    const size_t outFrames = size_t(frames / step);
+    out.resize(outFrames);
+    for (size_t i = 0; i < outFrames; ++i) {
+        const double t = i * step;
+        const size_t j = size_t(t);
+        const float f = float(t - j);
+        const float a = mono[j], b = (j + 1 < frames) ? mono[j + 1] : a;
+        out[i] = a + f * (b - a);
+    }
+    return !out.empty();
+}
+
+static inline void wav_put_u32(uint8_t* p, uint32_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); p[2] = uint8_t(v >> 16); p[3] = uint8_t(v >> 24); }
+static inline void wav_put_u16(uint8_t* p, uint16_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); }
+
+// Float32 WAV header padded with a JUNK chunk to exactly `headerBytes`
+// (even, >= 52), so sample data starts on a sector boundary. Sizes past
+// 4 GiB saturate, as most readers expect.
+static inline void wav_float_header(uint8_t* h, uint32_t headerBytes, int channels, uint32_t rate, uint64_t dataBytes) {
+    const uint64_t riff = dataBytes + headerBytes - 8;
+    memset(h, 0, headerBytes);
+    memcpy(h, "RIFF", 4);
+    wav_put_u32(h + 4, riff > 0xFFFFFFFFull ? 0xFFFFFFFFu : uint32_t(riff));
+    memcpy(h + 8, "WAVEfmt ", 8);
+    wav_put_u32(h + 16, 16);
+    wav_put_u16(h + 20, 3); // IEEE float
+    wav_put_u16(h + 22, uint16_t(channels));
+    wav_put_u32(h + 24, rate);
+    wav_put_u32(h + 28, rate * uint32_t(channels) * 4);
+    wav_put_u16(h + 32, uint16_t(channels * 4));
+    wav_put_u16(h + 34, 32);
+    memcpy(h + 36, "JUNK", 4);
+    wav_put_u32(h + 40, headerBytes - 52);
+    memcpy(h + headerBytes - 8, "data", 4);
+    wav_put_u32(h + headerBytes - 4, dataBytes > 0xFFFFFFFFull ? 0xFFFFFFFFu : uint32_t(dataBytes));
+}
@@ -0,0 +1,369 @@
+"""Offline renders of the Theremin engine from Python.
+
+Loads TheraminEngine.dll (see TheraminApi.h) with ctypes and renders
+straight into NumPy arrays: ``Engine.process`` writes into the array it is
+given, with no copy. ctypes releases the GIL for the length of every call
+into the engine, so threads rendering on separate engines run in parallel.
+
+Gesture scripts (see GestureScript.h for the format) are played the way
+``Theramin.exe /render`` plays them: events are applied at the start of
+the 128-frame block they fall in. Presets set parameters and EQ bands by
+name, in the app's config syntax for the bands.
+
+    import numpy as np
+    from theremin_render import Script, render, render_many
+
+    s = Script().mode(4).fx("delay", True)
+    for t in np.arange(0.0, 4.0, 0.005):
+        s.pos(t, 0.5 + 0.3 * np.sin(np.pi * t), 0.3)
+    s.end(5.0)
+    audio = render(s, preset={"master_db": -6, "eq.6": "highshelf 6000 -4 0.7"})
+    batch = render_many([s] * 8)   # float32, shape (frames, 2), 48 kHz
+
+``python theremin_render.py [seconds]`` runs the throughput benchmark.
+"""
+
+import ctypes
+import math
+import os
+import subprocess
+import sys
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+import numpy as np
+
+SAMPLE_RATE = 48000
+BLOCK_FRAMES = 128     # kBlockFrames: events land on these boundaries
+API_VERSION = 2        # THEREMIN_API_VERSION this module was written against
+
+OK, ERR_ARGUMENT, ERR_FULL = 0, -1, -2
+
+EVENT_POSITION, EVENT_MOTION, EVENT_GAIN, EVENT_VIBRATO, EVENT_LATCH, EVENT_RELEASE = range(6)
+
+PARAMS = {
+    "mode": 0, "mute": 1, "master_db": 2, "chord_mode": 3, "chord_tonic_hz": 4,
+    "control_frames": 5, "adaptive_smoothing": 6, "eq": 7, "compressor": 8,
+    "harmony": 9, "vocoder": 10, "delay": 11, "delay_bpm": 12,
+}
+EQ_TYPES = {"highpass": 0, "lowshelf": 1, "peak": 2, "highshelf": 3, "lowpass": 4}
+EQ_BANDS = 6
+
+# Script verbs that are parameters rather than gestures
+_FX_PARAMS = {"eq": "eq", "comp": "compressor", "harmony": "harmony", "vocoder": "vocoder", "delay": "delay"}
+_CHORD_MODES = {"off": 0, "chord": 1, "arp": 2}
+
+
+class _Event(ctypes.Structure):
+    _fields_ = [("time", ctypes.c_double), ("x", ctypes.c_float), ("y", ctypes.c_float), ("type", ctypes.c_int)]
+
+
+_lib = None
+
+
+def load(path=None):
+    """Load the engine library once; `path` defaults to the platform's name
+    for it next to this file, then on the search path."""
+    global _lib
+    if _lib is not None:
+        return _lib
+    name = "TheraminEngine.dll" if os.name == "nt" else "libTheraminEngine.so"
+    if path is None:
+        here = os.path.join(os.path.dirname(os.path.abspath(__file__)), name)
+        path = here if os.path.exists(here) else name
+    lib = ctypes.CDLL(path)  # CDLL, not PyDLL: calls run without the GIL
+    lib.theremin_api_version.restype = ctypes.c_int
+    lib.theremin_create.argtypes = [ctypes.c_float]
+    lib.theremin_create.restype = ctypes.c_void_p
+    lib.theremin_destroy.argtypes = [ctypes.c_void_p]
+    lib.theremin_destroy.restype = None
+    lib.theremin_process.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_uint32, ctypes.c_int]
+    lib.theremin_set_param.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_float]
+    lib.theremin_push_event.argtypes = [ctypes.c_void_p, ctypes.c_void_p]  # byref(_Event) or an address
+    lib.theremin_set_eq_band.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.c_float,
+                                         ctypes.c_float, ctypes.c_float, ctypes.c_int]
+    if lib.theremin_api_version() < API_VERSION:
+        raise RuntimeError("%s is API version %d, need %d" % (path, lib.theremin_api_version(), API_VERSION))
+    _lib = lib
+    return lib
+
+
+def _check(code, what):
+    if code != OK:
+        raise ValueError("%s: %s" % (what, "queue full" if code == ERR_FULL else "bad argument"))
+
+
+class Engine:
+    """One engine instance. Use from one rendering thread at a time."""
+
+    def __init__(self, sample_rate=SAMPLE_RATE, lib=None):
+        self.handle = None
+        self.lib = lib or load()
+        self.sample_rate = sample_rate
+        self.handle = self.lib.theremin_create(float(sample_rate))
+        if not self.handle:
+            raise ValueError("engine not created at %r Hz" % sample_rate)
+
+    def close(self):
+        if self.handle:
+            self.lib.theremin_destroy(self.handle)
+            self.handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def set(self, name, value):
+        _check(self.lib.theremin_set_param(self.handle, PARAMS[name], float(value)), name)
+
+    def set_eq_band(self, band, spec):
+        """`band` 1..6; `spec` as in the config file: "peak 450 -4 2" or "off"."""
+        words = spec.split()
+        if words == ["off"]:
+            code = self.lib.theremin_set_eq_band(self.handle, band - 1, 2, 1000.0, 0.0, 1.0, 0)
+        elif len(words) == 4 and words[0] in EQ_TYPES:
+            hz, gain_db, q = (float(w) for w in words[1:])
+            code = self.lib.theremin_set_eq_band(self.handle, band - 1, EQ_TYPES[words[0]], hz, gain_db, q, 1)
+        else:
+            code = ERR_ARGUMENT
+        _check(code, "eq.%d = %s" % (band, spec))
+
+    def apply(self, preset):
+        """Parameters by name ("mode", "delay", ...) and EQ bands as "eq.N"."""
+        for key, value in preset.items():
+            if key.startswith("eq."):
+                self.set_eq_band(int(key[3:]), value)
+            else:
+                self.set(key, value)
+
+    def push(self, t, kind, x=0.0, y=0.0):
+        """Queue one gesture event; when the queue is full it is drained by
+        a zero-frame process call (events apply in order either way)."""
+        ev = _Event(float(t), float(x), float(y), kind)
+        code = self.lib.theremin_push_event(self.handle, ctypes.byref(ev))
+        if code == ERR_FULL:
+            self.lib.theremin_process(self.handle, None, 0, 2)
+            code = self.lib.theremin_push_event(self.handle, ctypes.byref(ev))
+        _check(code, "event")
+
+    def process(self, out):
+        """Render into `out`, float32 C-contiguous, shape (frames, 2) or
+        (frames,) for mono. The engine writes the array in place."""
+        if out.dtype != np.float32 or not out.flags.c_contiguous or out.ndim not in (1, 2):
+            raise ValueError("out must be a C-contiguous float32 array of shape (frames,) or (frames, channels)")
+        channels = 1 if out.ndim == 1 else out.shape[1]
+        _check(self.lib.theremin_process(self.handle, out.ctypes.data, out.shape[0], channels), "process")
+        return out
+
+
+def load_preset(path):
+    """Read "key = value" lines ('#' comments) into a preset dict. EQ bands
+    use the config file syntax, e.g. "eq.3 = peak 450 -4 2"."""
+    preset = {}
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            key, sep, value = (w.strip() for w in line.partition("="))
+            if not sep or not (key in PARAMS or key.startswith("eq.")):
+                raise ValueError("%s:%d: cannot read %r" % (path, number, line))
+            preset[key] = value if key.startswith("eq.") else float(value)
+    return preset
+
+
+class Script:
+    """A gesture script, one timed event per line."""
+
+    def __init__(self):
+        self.items = []  # (time, verb, args)
+
+    def _add(self, t, verb, *args):
+        self.items.append((float(t), verb, args))
+        return self
+
+    def pos(self, t, x, y):
+        return self._add(t, "pos", float(x), float(y))
+
+    def gain(self, t, g):
+        return self._add(t, "gain", float(g))
+
+    def vibrato(self, t, depth):
+        return self._add(t, "vibrato", float(depth))
+
+    def latch(self, t):
+        return self._add(t, "latch")
+
+    def release(self, t, all_drones=False):
+        return self._add(t, "release", "all") if all_drones else self._add(t, "release")
+
+    def mode(self, m, t=0.0):
+        return self._add(t, "mode", int(m))
+
+    def chord(self, kind, t=0.0):
+        return self._add(t, "chord", kind)  # "off" | "chord" | "arp"
+
+    def fx(self, name, on, t=0.0):
+        return self._add(t, "fx", name, "on" if on else "off")
+
+    def master(self, db, t=0.0):
+        return self._add(t, "master", float(db))
+
+    def end(self, t):
+        return self._add(t, "end")
+
+    def text(self):
+        """The script in the file format Theramin.exe /render reads"""
+        return "".join(" ".join([repr(t), verb] + [str(a) for a in args]) + "\n" for t, verb, args in self.items)
+
+    def events(self):
+        """(time, kind, x, y) in time order, and the script length. A kind
+        >= 0 is an event type; -1 - kind is a parameter set to x."""
+        out = []
+        for t, verb, args in self.items:
+            if verb == "pos":
+                out.append((t, EVENT_POSITION, args[0], args[1]))
+            elif verb == "gain":
+                out.append((t, EVENT_GAIN, args[0], 0.0))
+            elif verb == "vibrato":
+                out.append((t, EVENT_VIBRATO, args[0], 0.0))
+            elif verb == "latch":
+                out.append((t, EVENT_LATCH, 0.0, 0.0))
+            elif verb == "release":
+                out.append((t, EVENT_RELEASE, 1.0 if args else 0.0, 0.0))
+            elif verb == "mode":
+                out.append((t, -1 - PARAMS["mode"], float(min(4, max(1, args[0]))), 0.0))
+            elif verb == "chord":
+                out.append((t, -1 - PARAMS["chord_mode"], float(_CHORD_MODES[args[0]]), 0.0))
+            elif verb == "fx":
+                out.append((t, -1 - PARAMS[_FX_PARAMS[args[0]]], 1.0 if args[1] == "on" else 0.0, 0.0))
+            elif verb == "master":
+                out.append((t, -1 - PARAMS["master_db"], args[0], 0.0))
+            # "end" only sets the length
+        out.sort(key=lambda e: e[0])  # stable, as script_parse
+        return out, max([t for t, _, _ in self.items] or [0.0])
+
+
+# theremin_event as a NumPy record, so a script's events are built in one go
+_EVENT_DTYPE = np.dtype([("time", np.float64), ("x", np.float32), ("y", np.float32), ("type", np.int32)], align=True)
+assert _EVENT_DTYPE.itemsize == ctypes.sizeof(_Event)
+
+
+def render(script, out=None, preset=None, engine=None, sample_rate=SAMPLE_RATE):
+    """Render a script into `out` (allocated as (frames, 2) float32 when
+    None) and return it. Between events the engine renders whole spans in
+    one call, so Python only runs once per event time."""
+    events, length = script.events()
+    frames = int(length * sample_rate)
+    if out is None:
+        out = np.empty((frames, 2), np.float32)
+    if out.dtype != np.float32 or not out.flags.c_contiguous or out.ndim != 2 or out.shape[0] < frames:
+        raise ValueError("out must be C-contiguous float32 with at least %d rows" % frames)
+    n = len(events)
+    table = np.zeros(n, _EVENT_DTYPE)
+    if n:
+        t, kind, x, y = zip(*events)
+        table["time"], table["type"], table["x"], table["y"] = t, kind, x, y
+    # Each event applies at the first block that starts at or after it
+    starts = (np.ceil(table["time"] * sample_rate / BLOCK_FRAMES) * BLOCK_FRAMES).astype(np.int64).tolist()
+    kinds = table["type"].tolist()
+
+    own = engine is None
+    engine = engine or Engine(sample_rate)
+    try:
+        if preset:
+            engine.apply(preset)
+        # The loop runs once per event time, so it calls the library
+        # directly with raw pointers into `table` and `out`
+        lib, handle = engine.lib, engine.handle
+        process, push, set_param = lib.theremin_process, lib.theremin_push_event, lib.theremin_set_param
+        ev, size = table.ctypes.data, _EVENT_DTYPE.itemsize
+        base, stride, channels = out.ctypes.data, out.strides[0], out.shape[1]
+        done, i = 0, 0
+        while done < frames:
+            while i < n and starts[i] <= done:
+                if kinds[i] < 0:
+                    _check(set_param(handle, -1 - kinds[i], float(table["x"][i])), "script parameter")
+                elif push(handle, ev + i * size) == ERR_FULL:
+                    process(handle, None, 0, channels)  # drain and retry
+                    continue
+                i += 1
+            stop = min(frames, max(starts[i], done + BLOCK_FRAMES)) if i < n else frames
+            process(handle, base + done * stride, stop - done, channels)
+            done = stop
+    finally:
+        if own:
+            engine.close()
+    return out[:frames]
+
+
+def render_many(scripts, preset=None, workers=None, sample_rate=SAMPLE_RATE):
+    """Render several scripts on a thread pool, one engine each; returns
+    their arrays in order."""
+    with ThreadPoolExecutor(max_workers=workers or os.cpu_count()) as pool:
+        return list(pool.map(lambda s: render(s, preset=preset, sample_rate=sample_rate), scripts))
+
+
+# ------------------------------
+# Throughput benchmark
+# ------------------------------
+
+def _bench_script(seconds):
+    """The bench's gesture script: a phrase at 200 events/s"""
+    s = Script().mode(4)
+    for k in range(int(seconds * 200)):
+        t = k / 200.0
+        s.pos(t, 0.5 + 0.25 * math.sin(2 * math.pi * 0.9 * t), 0.3)
+    return s.end(seconds)
+
+
+def benchmark(seconds=30.0, exe="Theramin.exe"):
+    """ns/frame for the same work natively and through Python"""
+    script = _bench_script(seconds)
+    frames = int(seconds * SAMPLE_RATE)
+    out = np.empty((frames, 2), np.float32)
+    print("Offline render, %.0f s at %d Hz, 200 events/s (ns/frame)" % (seconds, SAMPLE_RATE))
+
+    # Native floor: the engine alone, one call for the whole length
+    with Engine() as e:
+        e.push(0.0, EVENT_POSITION, 0.5, 0.3)
+        t0 = time.perf_counter()
+        e.process(out)
+        print("  engine, one process call   %8.1f" % ((time.perf_counter() - t0) * 1e9 / frames))
+
+    t0 = time.perf_counter()
+    render(script, out)
+    single = (time.perf_counter() - t0) * 1e9 / frames
+    print("  script through Python      %8.1f" % single)
+
+    workers = os.cpu_count() or 1
+    t0 = time.perf_counter()
+    render_many([script] * workers, workers=workers)
+    parallel = (time.perf_counter() - t0) * 1e9 / (frames * workers)
+    print("  %2d threads, per frame      %8.1f   (%.1fx one thread)" % (workers, parallel, single / parallel))
+
+    # The exe's own script renderer, including process start and the WAV write
+    if os.path.exists(exe):
+        fd, path = tempfile.mkstemp(suffix=".txt", text=True)
+        wav = path + ".wav"
+        try:
+            with os.fdopen(fd, "w") as f:
+                f.write(script.text())
+            t0 = time.perf_counter()
+            code = subprocess.run([exe, "/render", path, wav]).returncode
+            if code == 0:
+                print("  Theramin.exe /render       %8.1f" % ((time.perf_counter() - t0) * 1e9 / frames))
+        finally:
+            for p in (path, wav):
+                if os.path.exists(p):
+                    os.remove(p)
+
+
+if __name__ == "__main__":
+    benchmark(float(sys.argv[1]) if len(sys.argv) > 1 else 30.0)